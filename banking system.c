@@ -1,3 +1,6 @@
+/* POSIX and BSD extensions (st_mtim, lstat, S_ISSOCK, flock) stay visible under -std=c11 */
+#define _DEFAULT_SOURCE
+#define _DARWIN_C_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -8,21 +11,136 @@
 #include <errno.h>
 #include <limits.h>
 #include <unistd.h> 
+#include <stdatomic.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
 
 #define DB_DIR "database"
 #define INDEX_FILE "database/index.txt"
 #define LOG_FILE "database/transaction.log"
 #define HELP_REQ_FILE "database/help_requests.txt"
+#define RATES_FILE "database/rates.txt"
+#define LOCK_FILE "database/.lock"      /* held by the one console or server using the database */
+
+#ifdef __APPLE__
+#define ST_MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#else
+#define ST_MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#endif
+
+#define BASE_CURRENCY "MYR"
+#define CUR_LEN 4          /* 3-letter ISO code + NUL */
+#define MAX_BALANCES 4     /* currencies one account can hold */
+#define MAX_RATES 32
+#define RATE_SCALE 10000LL /* rates are kept with 4 decimal places */
+#define MAX_DEPOSIT_BASE 5000000LL /* RM50,000.00 in sen */
+
+#define JOURNAL_FILE "database/journal.log"
+#define LEDGER_FILE "database/ledger.txt"
+#define JOURNAL_WAL "database/journal.wal"   /* write-ahead records of postings in flight */
+#define MAX_JOURNAL_LINES 8
+#define JOURNAL_BATCH 64           /* entries buffered before the journal is written */
+#define JOURNAL_BUF_SIZE 32768
+
+/* amounts are stored as integer cents (sen) to keep arithmetic exact */
+typedef struct {
+    char currency[CUR_LEN];
+    long long cents;
+} Balance;
 
 typedef struct {
     char name[100];
     char id[16];       
     char type[10];     
     char pin[5];       
-    double balance;
     char accNum[12];   
+    char currency[CUR_LEN];          /* primary currency of the account */
+    int nBalances;
+    Balance balances[MAX_BALANCES];  /* balances[0] is the primary currency */
 } Account;
 
+/* value of one unit of each currency in MYR, scaled by RATE_SCALE */
+typedef struct {
+    char currency[CUR_LEN];
+    long long rate;
+} Rate;
+
+/* what stat() says about the rates file; any difference means it changed */
+typedef struct {
+    time_t sec;
+    long nsec;
+    off_t size;
+    ino_t ino;
+} FileStamp;
+
+typedef struct RateTable {
+    int count;
+    FileStamp stamp;          /* rates file the table was loaded from */
+    struct RateTable *next;   /* link in the retired list once replaced */
+    Rate rates[MAX_RATES];
+} RateTable;
+
+/* published table; readers register in g_rateReaders and load the pointer,
+   reload swaps it and frees replaced tables once no reader is left */
+static _Atomic(RateTable *) g_rates;
+static atomic_int g_rateReaders;
+static RateTable *g_retiredRates;   /* only touched by the thread that reloads */
+
+/* bank-side ledger accounts; customer accounts are the Account records themselves */
+typedef enum {
+    LEDGER_CUSTOMER,     /* liability: what the bank owes the customer */
+    LEDGER_CASH,         /* asset: money held by the bank */
+    LEDGER_FEE_INCOME,   /* income: fees charged on remittances */
+    LEDGER_FX_POSITION   /* clearing account for cross-currency transfers */
+} LedgerKind;
+
+/* one journal line; amount > 0 is a debit, amount < 0 a credit */
+typedef struct {
+    LedgerKind kind;
+    Account *acc;              /* set for LEDGER_CUSTOMER lines */
+    char currency[CUR_LEN];
+    long long amount;
+} JournalLine;
+
+/* a transaction; lines must sum to zero in every currency */
+typedef struct {
+    char memo[128];
+    int nLines;
+    JournalLine lines[MAX_JOURNAL_LINES];
+} JournalEntry;
+
+/* running trial-balance totals for one currency, all in cents */
+typedef struct {
+    char currency[CUR_LEN];
+    long long debits;       /* sum of all debit lines posted */
+    long long credits;      /* sum of all credit lines posted */
+    long long cash;         /* CASH, debit balance */
+    long long fxPosition;   /* FX_POSITION, debit balance (may be negative) */
+    long long customers;    /* all customer balances, credit balance */
+    long long feeIncome;    /* FEE_INCOME, credit balance */
+} LedgerTotals;
+
+typedef struct {
+    long long seq;          /* last journal entry number */
+    int nTotals;
+    LedgerTotals totals[MAX_RATES];
+    int pending;            /* entries buffered but not yet written */
+    bool autoFlush;         /* write after every posting (interactive use) */
+    bool broken;            /* a committed posting could not be applied; restart recovers it */
+    size_t len;
+    char buf[JOURNAL_BUF_SIZE];
+} Journal;
+
+static Journal g_journal;
+
 /* ---------- Utility I/O helpers ---------- */
 
 static void ensureDatabase() {
@@ -34,10 +152,30 @@ static void ensureDatabase() {
     FILE *f = fopen(INDEX_FILE, "a"); if (f) fclose(f);
     f = fopen(LOG_FILE, "a"); if (f) fclose(f);
     f = fopen(HELP_REQ_FILE, "a"); if (f) fclose(f);
+    f = fopen(RATES_FILE, "r");
+    if (f) fclose(f);
+    else if ((f = fopen(RATES_FILE, "w")) != NULL) {
+        fprintf(f, "# CODE RATE (value of 1 unit in MYR, up to 4 decimals)\n"
+                   "# Update by writing a new file and renaming it over this one.\n%s 1.0000\n", BASE_CURRENCY);
+        fclose(f);
+    }
+}
+
+/* take the database for this process; the lock is released when it exits.
+   Each process keeps its own journal buffer and ledger totals, so two at
+   once (console and server included) would overwrite each other's books.
+   Admin commands (delete, rates, books, bulk) exist only on the console,
+   so they need the teller server stopped first. */
+static bool lockDatabase() {
+    int fd = open(LOCK_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) { close(fd); return false; }
+    return true; // fd stays open for the life of the process
 }
 
 /* read a line from stdin, trim newline */
 static void readLine(char *buf, size_t n) {
+    fflush(stdout); // output is fully buffered; flush once per prompt
     if (fgets(buf, (int)n, stdin) == NULL) {
         buf[0] = '\0';
         return;
@@ -52,6 +190,52 @@ static bool isDigits(const char *s) {
     return true;
 }
 
+/* parse a non-negative decimal with at most `decimals` fraction digits into a scaled integer */
+static bool parseFixed(const char *s, int decimals, long long *out) {
+    long long whole = 0, frac = 0;
+    int intDigits = 0, fracDigits = 0;
+    const char *p = s;
+    if (!s || *s == '\0') return false;
+    for (; isdigit((unsigned char)*p); ++p) {
+        if (++intDigits > 12) return false; // keeps the scaled value far from overflow
+        whole = whole * 10 + (*p - '0');
+    }
+    if (*p == '.') {
+        for (++p; isdigit((unsigned char)*p); ++p) {
+            if (++fracDigits > decimals) return false;
+            frac = frac * 10 + (*p - '0');
+        }
+    }
+    if (*p != '\0' || intDigits + fracDigits == 0) return false;
+    for (; fracDigits < decimals; ++fracDigits) frac *= 10;
+    long long scale = 1;
+    for (int i = 0; i < decimals; ++i) scale *= 10;
+    *out = whole * scale + frac;
+    return true;
+}
+
+/* format cents as "1234.56" */
+static void formatAmount(char *buf, size_t n, long long cents) {
+    const char *sign = cents < 0 ? "-" : "";
+    unsigned long long v = cents < 0 ? 0ULL - (unsigned long long)cents : (unsigned long long)cents;
+    snprintf(buf, n, "%s%llu.%02llu", sign, v / 100, v % 100);
+}
+
+/* format cents with currency: "RM12.50" for ringgit, "USD 12.50" otherwise */
+static void formatMoney(char *buf, size_t n, const char *cur, long long cents) {
+    char amt[32];
+    formatAmount(amt, sizeof(amt), cents);
+    if (strcmp(cur, BASE_CURRENCY) == 0) snprintf(buf, n, "RM%s", amt);
+    else snprintf(buf, n, "%s %s", cur, amt);
+}
+
+/* check for a 3-letter uppercase currency code */
+static bool isCurrencyCode(const char *s) {
+    if (strlen(s) != 3) return false;
+    for (; *s; ++s) if (!isupper((unsigned char)*s)) return false;
+    return true;
+}
+
 /* append entry to transaction log with timestamp */
 static void appendLog(const char *entry) {
     FILE *f = fopen(LOG_FILE, "a");
@@ -93,16 +277,185 @@ static bool accountExists(const char *acc) {
     return found;
 }
 
+/* ---------- Exchange rates ---------- */
+
+static bool statRates(FileStamp *fs) {
+    struct stat st;
+    if (stat(RATES_FILE, &st) != 0) return false;
+    fs->sec = st.st_mtime;
+    fs->nsec = (long)ST_MTIME_NSEC(st);
+    fs->size = st.st_size;
+    fs->ino = st.st_ino;
+    return true;
+}
+
+static bool sameStamp(const FileStamp *a, const FileStamp *b) {
+    return a->sec == b->sec && a->nsec == b->nsec && a->size == b->size && a->ino == b->ino;
+}
+
+/* load rate table from RATES_FILE; returns NULL if the file cannot be read
+   or changed while it was being read (the next refresh tries again) */
+static RateTable *loadRateTable(void) {
+    FileStamp after;
+    RateTable *t = calloc(1, sizeof(*t));
+    if (!t) return NULL;
+    if (!statRates(&t->stamp)) { free(t); return NULL; }
+    FILE *f = fopen(RATES_FILE, "r");
+    if (!f) { free(t); return NULL; }
+
+    char line[128], code[8], rateStr[32];
+    bool hasBase = false;
+    while (fgets(line, sizeof(line), f) && t->count < MAX_RATES) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        long long rate;
+        if (sscanf(line, "%7s %31s", code, rateStr) != 2) continue;
+        if (!isCurrencyCode(code) || !parseFixed(rateStr, 4, &rate) || rate <= 0) continue;
+        if (strcmp(code, BASE_CURRENCY) == 0) { rate = RATE_SCALE; hasBase = true; }
+        strcpy(t->rates[t->count].currency, code);
+        t->rates[t->count].rate = rate;
+        t->count++;
+    }
+    fclose(f);
+    if (!statRates(&after) || !sameStamp(&t->stamp, &after)) { free(t); return NULL; }
+    // ringgit is the pivot currency and is always available
+    if (!hasBase && t->count < MAX_RATES) {
+        strcpy(t->rates[t->count].currency, BASE_CURRENCY);
+        t->rates[t->count].rate = RATE_SCALE;
+        t->count++;
+    }
+    return t;
+}
+
+/* readers bracket every use of the table with acquireRates()/releaseRates() */
+static const RateTable *acquireRates(void) {
+    atomic_fetch_add(&g_rateReaders, 1);
+    return atomic_load(&g_rates);
+}
+
+static void releaseRates(void) {
+    atomic_fetch_sub(&g_rateReaders, 1);
+}
+
+/* free replaced tables. A reader that registers after the swap can only see
+   the new table, so once the count drops to zero no one holds an old one. */
+static void reclaimRates(void) {
+    if (!g_retiredRates || atomic_load(&g_rateReaders) != 0) return;
+    while (g_retiredRates) {
+        RateTable *next = g_retiredRates->next;
+        free(g_retiredRates);
+        g_retiredRates = next;
+    }
+}
+
+/* load a fresh table and publish it; called from one thread only */
+static bool reloadRates(void) {
+    RateTable *t = loadRateTable();
+    if (!t) return false;
+    RateTable *old = atomic_exchange(&g_rates, t);
+    if (old) { old->next = g_retiredRates; g_retiredRates = old; }
+    reclaimRates();
+    return true;
+}
+
+/* reload the table only if the rates file changed since it was loaded;
+   returns false if a changed file could not be read */
+static bool refreshRatesIfChanged(void) {
+    FileStamp now;
+    bool changed = true;
+    reclaimRates();
+    if (!statRates(&now)) return false;
+    const RateTable *t = acquireRates();
+    if (t) changed = !sameStamp(&now, &t->stamp);
+    releaseRates();
+    return !changed || reloadRates();
+}
+
+/* release every table (only safe once no reader is left) */
+static void freeRates(void) {
+    free(atomic_exchange(&g_rates, NULL));
+    reclaimRates();
+}
+
+static bool findRate(const RateTable *t, const char *cur, long long *rate) {
+    if (!t) return false;
+    for (int i = 0; i < t->count; ++i) {
+        if (strcmp(t->rates[i].currency, cur) == 0) { *rate = t->rates[i].rate; return true; }
+    }
+    return false;
+}
+
+/* lock-free lookup of a currency rate */
+static bool lookupRate(const char *cur, long long *rate) {
+    bool found = findRate(acquireRates(), cur, rate);
+    releaseRates();
+    return found;
+}
+
+/* convert cents between currencies through MYR, rounding half up */
+static bool convertAmount(long long cents, const char *from, const char *to, long long *out) {
+    if (strcmp(from, to) == 0) { *out = cents; return true; }
+    long long rFrom, rTo;
+    const RateTable *t = acquireRates(); // both rates from the same table
+    bool found = findRate(t, from, &rFrom) && findRate(t, to, &rTo);
+    releaseRates();
+    if (!found) return false;
+    if (cents < 0 || cents > LLONG_MAX / 2 / rFrom) return false;
+    *out = (cents * rFrom * 2 + rTo) / (rTo * 2);
+    return true;
+}
+
+/* fee in basis points of amount, rounded half up to the nearest cent */
+static long long feeCents(long long cents, int bps) {
+    return (cents * bps + 5000) / 10000;
+}
+
+/* ---------- Account balances ---------- */
+
+static Balance *findBalance(Account *a, const char *cur) {
+    for (int i = 0; i < a->nBalances; ++i) {
+        if (strcmp(a->balances[i].currency, cur) == 0) return &a->balances[i];
+    }
+    return NULL;
+}
+
+/* find the balance for cur, opening an empty one if the account has room */
+static Balance *openBalance(Account *a, const char *cur) {
+    Balance *b = findBalance(a, cur);
+    if (b || a->nBalances >= MAX_BALANCES) return b;
+    b = &a->balances[a->nBalances++];
+    strcpy(b->currency, cur);
+    b->cents = 0;
+    return b;
+}
+
+static void printBalances(const Account *a) {
+    char money[48];
+    for (int i = 0; i < a->nBalances; ++i) {
+        formatMoney(money, sizeof(money), a->balances[i].currency, a->balances[i].cents);
+        printf("  %s%s\n", money, i == 0 ? " (primary)" : "");
+    }
+}
+
+/* write account record to the given path */
+static bool writeAccountFile(const Account *a, const char *path) {
+    char amt[32];
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    // store lines: name, id, type, pin, primary balance, currency, then "CUR amount" per extra balance
+    formatAmount(amt, sizeof(amt), a->balances[0].cents);
+    fprintf(f, "%s\n%s\n%s\n%s\n%s\n%s\n", a->name, a->id, a->type, a->pin, amt, a->currency);
+    for (int i = 1; i < a->nBalances; ++i) {
+        formatAmount(amt, sizeof(amt), a->balances[i].cents);
+        fprintf(f, "%s %s\n", a->balances[i].currency, amt);
+    }
+    return fclose(f) == 0;
+}
+
 /* write account record to file path database/<acc>.txt */
 static bool saveAccountToFile(const Account *a) {
     char path[256];
     snprintf(path, sizeof(path), "%s/%s.txt", DB_DIR, a->accNum);
-    FILE *f = fopen(path, "w");
-    if (!f) return false;
-    // store lines: name, id, type, pin, balance
-    fprintf(f, "%s\n%s\n%s\n%s\n%.2f\n", a->name, a->id, a->type, a->pin, a->balance);
-    fclose(f);
-    return true;
+    return writeAccountFile(a, path);
 }
 
 // Helper function to read a line from file and strip newline.
@@ -133,13 +486,30 @@ static bool loadAccountFromFile(const char *accNum, Account *out) {
     // 3. Type
     if (!readLineFromFile(f, out->type, sizeof(out->type))) goto error_close;
     
-    // 4. PIN
-    if (!readLineFromFile(f, out->pin, sizeof(out->pin))) goto error_close;
+    // 4. PIN (read through buf so the newline is consumed with it)
+    if (!readLineFromFile(f, buf, sizeof(buf)) || strlen(buf) >= sizeof(out->pin)) goto error_close;
+    strcpy(out->pin, buf);
     
-    // 5. Balance (Must use fscanf/strtod for numbers)
-    double bal = 0.0;
-    if (fscanf(f, "%lf", &bal) != 1) goto error_close;
-    out->balance = bal;
+    // 5. Primary balance (parsed exactly into cents)
+    long long cents;
+    if (!readLineFromFile(f, buf, sizeof(buf)) || !parseFixed(buf, 2, &cents)) goto error_close;
+
+    // 6. Currency (older records have none and are ringgit accounts)
+    if (!readLineFromFile(f, buf, sizeof(buf)) || !isCurrencyCode(buf)) strcpy(buf, BASE_CURRENCY);
+    strcpy(out->currency, buf);
+    out->nBalances = 1;
+    strcpy(out->balances[0].currency, out->currency);
+    out->balances[0].cents = cents;
+
+    // 7+. Extra currency balances: "CUR amount"
+    while (out->nBalances < MAX_BALANCES && readLineFromFile(f, buf, sizeof(buf))) {
+        char code[8], amt[32];
+        if (sscanf(buf, "%7s %31s", code, amt) != 2) continue;
+        if (!isCurrencyCode(code) || !parseFixed(amt, 2, &cents) || findBalance(out, code)) continue;
+        strcpy(out->balances[out->nBalances].currency, code);
+        out->balances[out->nBalances].cents = cents;
+        out->nBalances++;
+    }
     
     // Set account number
     strncpy(out->accNum, accNum, sizeof(out->accNum));
@@ -152,11 +522,6 @@ error_close:
     return false;
 }
 
-/* update account file (overwrite) */
-static bool updateAccountFile(const Account *a) {
-    return saveAccountToFile(a);
-}
-
 /* add account number to index file */
 static bool appendIndex(const char *acc) {
     FILE *f = fopen(INDEX_FILE, "a");
@@ -188,6 +553,423 @@ static bool removeFromIndex(const char *acc) {
     return removed;
 }
 
+/* ---------- Double-entry journal ---------- */
+
+static void formatNow(char *buf, size_t n) {
+    time_t t = time(NULL);
+    struct tm *tm = localtime(&t);
+    strftime(buf, n, "%Y-%m-%d %H:%M:%S", tm);
+}
+
+/* totals slot for a currency in totals[0..*n), created on first use */
+static LedgerTotals *findTotals(LedgerTotals *totals, int *n, const char *cur) {
+    for (int i = 0; i < *n; ++i) {
+        if (strcmp(totals[i].currency, cur) == 0) return &totals[i];
+    }
+    if (*n >= MAX_RATES) return NULL;
+    LedgerTotals *t = &totals[(*n)++];
+    memset(t, 0, sizeof(*t));
+    strcpy(t->currency, cur);
+    return t;
+}
+
+static LedgerTotals *ledgerTotals(const char *cur) {
+    return findTotals(g_journal.totals, &g_journal.nTotals, cur);
+}
+
+/* parse an amount that may carry a leading minus sign */
+static bool parseSignedAmount(const char *s, long long *out) {
+    bool neg = (*s == '-');
+    if (!parseFixed(neg ? s + 1 : s, 2, out)) return false;
+    if (neg) *out = -*out;
+    return true;
+}
+
+/* write running totals to path; callers rename it over LEDGER_FILE */
+static bool writeLedgerFile(const LedgerTotals *totals, int n, long long seq, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "SEQ %lld\n", seq);
+    fprintf(f, "# CUR debits credits cash fx_position customers fee_income\n");
+    for (int i = 0; i < n; ++i) {
+        const LedgerTotals *t = &totals[i];
+        const long long v[6] = { t->debits, t->credits, t->cash, t->fxPosition, t->customers, t->feeIncome };
+        char amt[32];
+        fprintf(f, "%s", t->currency);
+        for (int k = 0; k < 6; ++k) { formatAmount(amt, sizeof(amt), v[k]); fprintf(f, " %s", amt); }
+        fprintf(f, "\n");
+    }
+    return fclose(f) == 0;
+}
+
+/* number of the last entry in JOURNAL_FILE (0 if none) */
+static long long lastJournalSeq(void) {
+    FILE *f = fopen(JOURNAL_FILE, "r");
+    if (!f) return 0;
+    char line[256];
+    long long seq = 0, n;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' && sscanf(line + 1, "%lld", &n) == 1 && n > seq) seq = n;
+    }
+    fclose(f);
+    return seq;
+}
+
+/* append text to JOURNAL_FILE; returns how many bytes made it */
+static size_t appendJournalText(const char *text, size_t len) {
+    int fd = open(JOURNAL_FILE, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) return 0;
+    size_t done = 0;
+    while (done < len) {
+        ssize_t w = write(fd, text + done, len - done);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        done += (size_t)w;
+    }
+    close(fd);
+    return done;
+}
+
+/* write buffered journal text. A partial write drops only what was written,
+   so a retry never duplicates text. Once everything is out, the write-ahead
+   records are no longer needed and the log is truncated. */
+static bool flushJournal(void) {
+    if (g_journal.len > 0) {
+        size_t done = appendJournalText(g_journal.buf, g_journal.len);
+        memmove(g_journal.buf, g_journal.buf + done, g_journal.len - done);
+        g_journal.len -= done;
+        if (g_journal.len > 0) return false;
+    }
+    g_journal.pending = 0;
+    if (!g_journal.broken) {
+        FILE *w = fopen(JOURNAL_WAL, "w");
+        if (w) fclose(w);
+    }
+    return true;
+}
+
+static const char *ledgerName(const JournalLine *l) {
+    switch (l->kind) {
+    case LEDGER_CUSTOMER: return l->acc->accNum;
+    case LEDGER_CASH: return "CASH";
+    case LEDGER_FEE_INCOME: return "FEE_INCOME";
+    case LEDGER_FX_POSITION: return "FX_POSITION";
+    }
+    return "?";
+}
+
+/* add a line to an entry; zero amounts are dropped */
+static void journalAdd(JournalEntry *e, LedgerKind kind, Account *acc, const char *cur, long long amount) {
+    if (amount == 0 || e->nLines >= MAX_JOURNAL_LINES) return;
+    JournalLine *l = &e->lines[e->nLines++];
+    l->kind = kind;
+    l->acc = acc;
+    strcpy(l->currency, cur);
+    l->amount = amount;
+}
+
+/* post an entry: every line is applied or none is.
+   1. staged copies of the changed accounts and the new ledger totals are
+      written to temp files named after the entry number;
+   2. a write-ahead record listing those files and the journal text is
+      appended to JOURNAL_WAL, ending in COMMIT -- the commit point;
+   3. the temp files are renamed into place.
+   A crash before COMMIT leaves only temp files, which recoverJournal()
+   deletes; a crash after it is rolled forward by recoverJournal(). Nothing
+   is fsync'd, so this covers a killed process, not a power loss. The
+   callers' Account structs are updated on success. */
+static bool postJournal(JournalEntry *e, char *err, size_t errn) {
+    Account staged[MAX_JOURNAL_LINES];
+    Account *orig[MAX_JOURNAL_LINES];
+    int nStaged = 0;
+    LedgerTotals totals[MAX_RATES];
+    int nTotals = g_journal.nTotals;
+    long long seq = g_journal.seq + 1;
+
+    if (g_journal.broken) { snprintf(err, errn, "journal needs recovery; restart the program"); return false; }
+    memcpy(totals, g_journal.totals, sizeof(totals));
+
+    // 1. every currency must net to zero
+    for (int i = 0; i < e->nLines; ++i) {
+        long long sum = 0;
+        for (int k = 0; k < e->nLines; ++k) {
+            if (strcmp(e->lines[k].currency, e->lines[i].currency) == 0) sum += e->lines[k].amount;
+        }
+        if (sum != 0) { snprintf(err, errn, "entry does not balance in %s", e->lines[i].currency); return false; }
+        if (!findTotals(totals, &nTotals, e->lines[i].currency)) { snprintf(err, errn, "too many currencies in ledger"); return false; }
+    }
+
+    // 2. apply customer lines to staged copies; customer balances are credit-normal
+    for (int i = 0; i < e->nLines; ++i) {
+        JournalLine *l = &e->lines[i];
+        if (l->kind != LEDGER_CUSTOMER) continue;
+        int k = 0;
+        while (k < nStaged && orig[k] != l->acc) ++k;
+        if (k == nStaged) { orig[k] = l->acc; staged[k] = *l->acc; ++nStaged; }
+        Balance *b = openBalance(&staged[k], l->currency);
+        if (!b) { snprintf(err, errn, "account %s cannot hold another currency", l->acc->accNum); return false; }
+        if (b->cents - l->amount < 0) { snprintf(err, errn, "insufficient funds in %s", l->acc->accNum); return false; }
+        b->cents -= l->amount;
+    }
+
+    // 3. new running trial-balance totals
+    for (int i = 0; i < e->nLines; ++i) {
+        const JournalLine *l = &e->lines[i];
+        LedgerTotals *t = findTotals(totals, &nTotals, l->currency);
+        if (l->amount > 0) t->debits += l->amount; else t->credits -= l->amount;
+        switch (l->kind) {
+        case LEDGER_CUSTOMER: t->customers -= l->amount; break;
+        case LEDGER_CASH: t->cash += l->amount; break;
+        case LEDGER_FEE_INCOME: t->feeIncome -= l->amount; break;
+        case LEDGER_FX_POSITION: t->fxPosition += l->amount; break;
+        }
+    }
+
+    // 4. journal text; make room in the buffer before anything touches disk
+    char entry[1024], tb[64], amt[32];
+    formatNow(tb, sizeof(tb));
+    int len = snprintf(entry, sizeof(entry), "#%lld [%s] %s\n", seq, tb, e->memo);
+    for (int i = 0; i < e->nLines && len < (int)sizeof(entry); ++i) {
+        const JournalLine *l = &e->lines[i];
+        formatAmount(amt, sizeof(amt), l->amount > 0 ? l->amount : -l->amount);
+        len += snprintf(entry + len, sizeof(entry) - (size_t)len, "  %s %-12s %s %s\n",
+                        l->amount > 0 ? "Dr" : "Cr", ledgerName(l), l->currency, amt);
+    }
+    if (len >= (int)sizeof(entry)) len = (int)sizeof(entry) - 1;
+    if (g_journal.len + (size_t)len > sizeof(g_journal.buf)) flushJournal();
+    if (g_journal.len + (size_t)len > sizeof(g_journal.buf)) {
+        snprintf(err, errn, "cannot write journal %s", JOURNAL_FILE);
+        return false;
+    }
+
+    // 5. stage accounts and ledger in temp files (slot nStaged is the ledger)
+    char tmp[MAX_JOURNAL_LINES + 1][256], dst[MAX_JOURNAL_LINES + 1][256];
+    int nFiles = nStaged + 1;
+    for (int k = 0; k < nStaged; ++k) {
+        snprintf(tmp[k], sizeof(tmp[k]), "%s/%s.%lld.tmp", DB_DIR, staged[k].accNum, seq);
+        snprintf(dst[k], sizeof(dst[k]), "%s/%s.txt", DB_DIR, staged[k].accNum);
+    }
+    snprintf(tmp[nStaged], sizeof(tmp[nStaged]), "%s/ledger.%lld.tmp", DB_DIR, seq);
+    snprintf(dst[nStaged], sizeof(dst[nStaged]), "%s", LEDGER_FILE);
+    for (int k = 0; k < nFiles; ++k) {
+        bool ok = k < nStaged ? writeAccountFile(&staged[k], tmp[k]) : writeLedgerFile(totals, nTotals, seq, tmp[k]);
+        if (!ok) {
+            for (int j = 0; j <= k; ++j) remove(tmp[j]);
+            snprintf(err, errn, "failed to write %.80s", tmp[k]);
+            return false;
+        }
+    }
+
+    // 6. commit: append the write-ahead record
+    char rec[4096];
+    int rlen = snprintf(rec, sizeof(rec), "BEGIN %lld\n", seq);
+    for (int k = 0; k < nFiles; ++k) rlen += snprintf(rec + rlen, sizeof(rec) - (size_t)rlen, "FILE %s %s\n", tmp[k], dst[k]);
+    for (char *p = entry, *nl; p < entry + len; p = nl + 1) {
+        nl = memchr(p, '\n', (size_t)(entry + len - p));
+        if (!nl) break;
+        rlen += snprintf(rec + rlen, sizeof(rec) - (size_t)rlen, "TEXT %.*s\n", (int)(nl - p), p);
+    }
+    rlen += snprintf(rec + rlen, sizeof(rec) - (size_t)rlen, "COMMIT %lld\n", seq);
+    FILE *w = fopen(JOURNAL_WAL, "a");
+    if (!w) {
+        for (int k = 0; k < nFiles; ++k) remove(tmp[k]);
+        snprintf(err, errn, "cannot open %s", JOURNAL_WAL);
+        return false;
+    }
+    bool logged = fputs(rec, w) >= 0;
+    if (fclose(w) != 0 || !logged) {
+        // the record may or may not have reached disk; leave the temp files for recovery
+        g_journal.broken = true;
+        snprintf(err, errn, "failed to write %s; restart to recover", JOURNAL_WAL);
+        return false;
+    }
+
+    // 7. apply
+    for (int k = 0; k < nFiles; ++k) {
+        if (rename(tmp[k], dst[k]) != 0) {
+            g_journal.broken = true;
+            snprintf(err, errn, "entry #%lld recorded but not fully applied; restart to complete it", seq);
+            return false;
+        }
+    }
+    for (int k = 0; k < nStaged; ++k) *orig[k] = staged[k];
+    memcpy(g_journal.totals, totals, sizeof(totals));
+    g_journal.nTotals = nTotals;
+    g_journal.seq = seq;
+
+    // 8. buffer the journal text; write it out when the batch is full
+    memcpy(g_journal.buf + g_journal.len, entry, (size_t)len);
+    g_journal.len += (size_t)len;
+    g_journal.pending++;
+    if (g_journal.autoFlush || g_journal.pending >= JOURNAL_BATCH) {
+        if (!flushJournal()) printf("Warning: failed to write journal to %s.\n", JOURNAL_FILE);
+    }
+    return true;
+}
+
+/* O(1) per currency: debits equal credits, and assets equal liabilities plus income */
+static bool booksBalance(void) {
+    for (int i = 0; i < g_journal.nTotals; ++i) {
+        const LedgerTotals *t = &g_journal.totals[i];
+        if (t->debits != t->credits) return false;
+        if (t->cash + t->fxPosition != t->customers + t->feeIncome) return false;
+    }
+    return true;
+}
+
+/* finish postings a crash interrupted. Records with COMMIT are rolled
+   forward: leftover temp files are renamed into place and journal text
+   missing from JOURNAL_FILE is appended once all of them are in place.
+   Records without COMMIT are rolled back by deleting their temp files. If
+   a record cannot be completed, recovery stops there, the log is kept for
+   the next start and postings are refused until then. */
+static void recoverJournal(void) {
+    FILE *w = fopen(JOURNAL_WAL, "r");
+    if (!w) return;
+    long long lastSeq = lastJournalSeq(), seq = 0, commitSeq;
+    char line[1200], text[4096];
+    char tmp[MAX_JOURNAL_LINES + 1][256], dst[MAX_JOURNAL_LINES + 1][256];
+    int nFiles = 0, recovered = 0;
+    size_t textLen = 0;
+    bool open = false, ok = true;
+
+    while (fgets(line, sizeof(line), w)) {
+        line[strcspn(line, "\n")] = 0;
+        if (sscanf(line, "BEGIN %lld", &seq) == 1) {
+            for (int k = 0; open && k < nFiles; ++k) remove(tmp[k]); // previous record never committed
+            open = true;
+            nFiles = 0;
+            textLen = 0;
+        } else if (!open) {
+            continue;
+        } else if (strncmp(line, "FILE ", 5) == 0 && nFiles <= MAX_JOURNAL_LINES) {
+            if (sscanf(line + 5, "%255s %255s", tmp[nFiles], dst[nFiles]) == 2) ++nFiles;
+        } else if (strncmp(line, "TEXT ", 5) == 0) {
+            textLen += (size_t)snprintf(text + textLen, sizeof(text) - textLen, "%s\n", line + 5);
+            if (textLen >= sizeof(text)) textLen = sizeof(text) - 1;
+        } else if (sscanf(line, "COMMIT %lld", &commitSeq) == 1 && commitSeq == seq) {
+            bool touched = false;
+            for (int k = 0; ok && k < nFiles; ++k) {
+                if (access(tmp[k], F_OK) != 0) continue; // already renamed before the crash
+                if (rename(tmp[k], dst[k]) != 0) { printf("Warning: could not restore %s from %s.\n", dst[k], tmp[k]); ok = false; }
+                touched = true;
+            }
+            if (ok && seq > lastSeq) {
+                if (appendJournalText(text, textLen) != textLen) ok = false;
+                else lastSeq = seq;
+                touched = true;
+            }
+            if (!ok) break; // later records wait until this one can be completed
+            if (touched) ++recovered;
+            open = false;
+        }
+    }
+    for (int k = 0; ok && open && k < nFiles; ++k) remove(tmp[k]);
+    fclose(w);
+    if (ok) { w = fopen(JOURNAL_WAL, "w"); if (w) fclose(w); }
+    else {
+        g_journal.broken = true;
+        printf("Warning: journal recovery incomplete; %s kept for the next start and postings are disabled.\n", JOURNAL_WAL);
+    }
+    if (recovered > 0) printf("Recovered %d interrupted journal entr%s.\n", recovered, recovered == 1 ? "y" : "ies");
+}
+
+/* sum every customer balance per currency from the account files */
+static int sumAccountFiles(LedgerTotals *sums) {
+    int n = 0;
+    FILE *idx = fopen(INDEX_FILE, "r");
+    if (!idx) return 0;
+    char acc[64];
+    Account a;
+    while (fgets(acc, sizeof(acc), idx)) {
+        acc[strcspn(acc, "\n")] = 0;
+        if (!loadAccountFromFile(acc, &a)) continue;
+        for (int i = 0; i < a.nBalances; ++i) {
+            LedgerTotals *t = findTotals(sums, &n, a.balances[i].currency);
+            if (t) t->customers += a.balances[i].cents;
+        }
+    }
+    fclose(idx);
+    return n;
+}
+
+/* compare the ledger with the account files and the journal; prints every
+   difference and returns true if there are none */
+static bool reconcileLedger(void) {
+    LedgerTotals sums[MAX_RATES];
+    int nSums = sumAccountFiles(sums);
+    bool ok = true;
+    char want[32], have[32];
+    for (int i = 0; i < nSums; ++i) ledgerTotals(sums[i].currency); // currencies only the files know about
+    for (int i = 0; i < g_journal.nTotals; ++i) {
+        const LedgerTotals *t = &g_journal.totals[i];
+        long long held = 0;
+        for (int k = 0; k < nSums; ++k) if (strcmp(sums[k].currency, t->currency) == 0) held = sums[k].customers;
+        if (held == t->customers) continue;
+        formatAmount(want, sizeof(want), t->customers);
+        formatAmount(have, sizeof(have), held);
+        printf("Warning: ledger drift in %s: ledger CUSTOMERS %s, account files hold %s.\n", t->currency, want, have);
+        ok = false;
+    }
+    long long written = lastJournalSeq();
+    if (written + g_journal.pending != g_journal.seq) {
+        printf("Warning: ledger is at entry #%lld but %s ends at #%lld (%d buffered).\n",
+               g_journal.seq, JOURNAL_FILE, written, g_journal.pending);
+        ok = false;
+    }
+    return ok;
+}
+
+/* recover interrupted postings, load running totals and check them against
+   the account files; on first run, post opening balances for existing accounts */
+static void initJournal(void) {
+    memset(&g_journal, 0, sizeof(g_journal));
+    g_journal.autoFlush = true;
+    recoverJournal();
+
+    FILE *f = fopen(LEDGER_FILE, "r");
+    if (f) {
+        char line[256], code[8], v[6][32];
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "SEQ %lld", &g_journal.seq) == 1) continue;
+            if (sscanf(line, "%7s %31s %31s %31s %31s %31s %31s", code, v[0], v[1], v[2], v[3], v[4], v[5]) != 7) continue;
+            if (!isCurrencyCode(code)) continue;
+            LedgerTotals *t = ledgerTotals(code);
+            if (!t) break;
+            long long *dst[6] = { &t->debits, &t->credits, &t->cash, &t->fxPosition, &t->customers, &t->feeIncome };
+            for (int k = 0; k < 6; ++k) if (!parseSignedAmount(v[k], dst[k])) *dst[k] = 0;
+        }
+        fclose(f);
+        if (!reconcileLedger()) printf("Run 'books' for the full trial balance.\n");
+        return;
+    }
+
+    // opening entry: Dr CASH / Cr customers for whatever the accounts already hold
+    LedgerTotals sums[MAX_RATES];
+    int nSums = sumAccountFiles(sums);
+    for (int i = 0; i < nSums; ++i) {
+        LedgerTotals *t = ledgerTotals(sums[i].currency);
+        t->debits = t->credits = t->cash = t->customers = sums[i].customers;
+    }
+    g_journal.seq = lastJournalSeq() + 1;
+    char entry[2048], tb[64], amt[32];
+    formatNow(tb, sizeof(tb));
+    int len = snprintf(entry, sizeof(entry), "#%lld [%s] OPENING balances of existing accounts\n", g_journal.seq, tb);
+    for (int i = 0; i < g_journal.nTotals && len < (int)sizeof(entry); ++i) {
+        formatAmount(amt, sizeof(amt), g_journal.totals[i].cash);
+        len += snprintf(entry + len, sizeof(entry) - (size_t)len, "  Dr %-12s %s %s\n  Cr %-12s %s %s\n",
+                        "CASH", g_journal.totals[i].currency, amt, "CUSTOMERS", g_journal.totals[i].currency, amt);
+    }
+    if (len >= (int)sizeof(entry)) len = (int)sizeof(entry) - 1;
+    memcpy(g_journal.buf, entry, (size_t)len);
+    g_journal.len = (size_t)len;
+    g_journal.pending = 1;
+    if (!writeLedgerFile(g_journal.totals, g_journal.nTotals, g_journal.seq, "database/ledger.tmp")
+        || rename("database/ledger.tmp", LEDGER_FILE) != 0 || !flushJournal()) {
+        printf("Warning: failed to initialise ledger in %s.\n", LEDGER_FILE);
+    }
+}
+
 /* ---------- Account number generation (7-9 digits, unique) ---------- */
 static void generateAccountNumber(char *out, size_t n) {
     static bool seeded = false;
@@ -211,13 +993,7 @@ static void generateAccountNumber(char *out, size_t n) {
 
 /* small "progress" animation (no real delay; just prints nice bar) */
 static void printProgressBar(const char *message) {
-    printf("\n%s\n", message);
-    printf("[");
-    for (int i = 0; i < 20; ++i) {
-        if (i < 16) putchar('=');
-        else putchar(' ');
-    }
-    printf("] Done.\n");
+    printf("\n%s\n[================    ] Done.\n", message);
 }
 
 /* case-insensitive compare for names */
@@ -230,19 +1006,86 @@ static bool strCaseEqual(const char *a, const char *b) {
 
 /* ---------- Validated input helpers ---------- */
 
+/* The check* functions hold the validation rules and write the reason into
+   err on failure; the prompt* functions loop on them for the console, and
+   teller sessions call them directly. */
+
+static bool checkID(const char *in, char *err, size_t n) {
+    if (!isDigits(in)) { snprintf(err, n, "ID must contain only digits. Try again."); return false; }
+    if (strlen(in) != 7) {
+        snprintf(err, n, "ID must be exactly 7 digits long. You entered %zu digits.", strlen(in));
+        return false;
+    }
+    return true;
+}
+
+static bool checkPIN(const char *in, char *err, size_t n) {
+    if (!isDigits(in)) { snprintf(err, n, "PIN must contain only digits. Try again."); return false; }
+    if (strlen(in) != 4) { snprintf(err, n, "PIN must be exactly 4 digits."); return false; }
+    return true;
+}
+
+/* format only; existence is a storage lookup done separately */
+static bool checkAccountNumber(const char *in, char *err, size_t n) {
+    if (!isDigits(in)) { snprintf(err, n, "Account numbers must be digits only."); return false; }
+    size_t len = strlen(in);
+    if (len < 7 || len > 9) {
+        snprintf(err, n, "Account number must be between 7 and 9 digits (you entered %zu digits).", len);
+        return false;
+    }
+    return true;
+}
+
+static bool checkAmount(const char *in, const char *cur, long long maxAllowed, bool enforceMax,
+                        long long *out, char *err, size_t n) {
+    char money[48];
+    if (in[0] == '-') { snprintf(err, n, "negative amounts not allowed."); return false; }
+    // digits with at most one dot and two decimal places
+    if (!parseFixed(in, 2, out)) {
+        snprintf(err, n, "please enter a valid number with at most 2 decimals (e.g., 10.50). You typed: %s", in);
+        return false;
+    }
+    if (*out <= 0) {
+        formatMoney(money, sizeof(money), cur, 0);
+        snprintf(err, n, "amount must be greater than %s.", money);
+        return false;
+    }
+    if (enforceMax && *out > maxAllowed) {
+        formatMoney(money, sizeof(money), cur, maxAllowed);
+        snprintf(err, n, "amount exceeds the allowed maximum of %s per operation.", money);
+        return false;
+    }
+    return true;
+}
+
+/* normalise an account type answer in place (lowercase) and require savings/current */
+static bool checkAccountType(char *in, char *err, size_t n) {
+    for (size_t i = 0; in[i]; ++i) in[i] = (char)tolower((unsigned char)in[i]);
+    if (strcmp(in, "savings") == 0 || strcmp(in, "current") == 0) return true;
+    snprintf(err, n, "invalid account type. Enter 'savings' or 'current'.");
+    return false;
+}
+
+/* normalise a currency answer in place (empty picks defaultCur). A currency
+   the account already holds (held may be NULL) needs no rate; any other
+   one must have a loaded rate. */
+static bool checkCurrency(char *in, size_t inSize, const char *defaultCur, Account *held, char *err, size_t n) {
+    long long rate;
+    if (in[0] == '\0') snprintf(in, inSize, "%s", defaultCur);
+    for (size_t i = 0; in[i]; ++i) in[i] = (char)toupper((unsigned char)in[i]);
+    if (!isCurrencyCode(in)) { snprintf(err, n, "currency must be a 3-letter code (e.g., MYR, USD)."); return false; }
+    if (held && findBalance(held, in)) return true;
+    if (!lookupRate(in, &rate)) { snprintf(err, n, "no exchange rate loaded for %s.", in); return false; }
+    return true;
+}
+
 /* get 7-digit ID (numbers only) */
 static void promptID(char *out, size_t n) {
+    char err[160];
     while (1) {
         printf("Enter Identification Number (exactly 7 digits): ");
         readLine(out, n);
-        if (!isDigits(out)) {
-            printf("Error: ID must contain only digits. Try again.\n");
-            continue;
-        }
-        if ((int)strlen(out) != 7) {
-            printf("Error: ID must be exactly 7 digits long. You entered %zu digits.\n", strlen(out));
-            continue;
-        }
+        if (!checkID(out, err, sizeof(err))) { printf("Error: %s\n", err); continue; }
         printf("OK: ID accepted.\n");
         break;
     }
@@ -250,18 +1093,12 @@ static void promptID(char *out, size_t n) {
 
 /* get 4-digit PIN (numbers only) */
 static void promptPIN(char *out, size_t n, const char *promptText) {
+    char err[160];
     (void)n;
     while (1) {
         printf("%s (exactly 4 digits): ", promptText);
         readLine(out, 8); // read more to flush newline if necessary
-        if (!isDigits(out)) {
-            printf("Error: PIN must contain only digits. Try again.\n");
-            continue;
-        }
-        if (strlen(out) != 4) {
-            printf("Error: PIN must be exactly 4 digits.\n");
-            continue;
-        }
+        if (!checkPIN(out, err, sizeof(err))) { printf("Error: %s\n", err); continue; }
         printf("OK: PIN accepted.\n");
         break;
     }
@@ -269,18 +1106,11 @@ static void promptPIN(char *out, size_t n, const char *promptText) {
 
 /* prompt for account number (7-9 digits) and ensure it exists */
 static void promptExistingAccount(char *out, size_t n) {
+    char err[160];
     while (1) {
         printf("Enter account number (7-9 digits): ");
         readLine(out, n);
-        if (!isDigits(out)) {
-            printf("Error: Account numbers must be digits only.\n");
-            continue;
-        }
-        int len = (int)strlen(out);
-        if (len < 7 || len > 9) {
-            printf("Error: Account number must be between 7 and 9 digits (you entered %d digits).\n", len);
-            continue;
-        }
+        if (!checkAccountNumber(out, err, sizeof(err))) { printf("Error: %s\n", err); continue; }
         if (!accountExists(out)) {
             printf("Error: Account number %s is not registered.\n", out);
             continue;
@@ -290,39 +1120,86 @@ static void promptExistingAccount(char *out, size_t n) {
     }
 }
 
-/* prompt for a positive decimal amount (greater than 0) and optional upper limit */
-static double promptAmount(const char *promptText, double maxAllowed, bool enforceMax) {
-    char buf[64];
-    double val;
+/* what amounts are typed after: "RM" for ringgit, else the currency code */
+static const char *amountPrefix(const char *cur) {
+    return strcmp(cur, BASE_CURRENCY) == 0 ? "RM" : cur;
+}
+
+/* e.g. "Enter deposit amount (greater than RM0.00, max RM50000.00)" */
+static void amountPrompt(char *out, size_t n, const char *what, const char *cur, long long maxAllowed, bool showMax) {
+    char zero[48], max[48];
+    formatMoney(zero, sizeof(zero), cur, 0);
+    if (showMax) {
+        formatMoney(max, sizeof(max), cur, maxAllowed);
+        snprintf(out, n, "Enter %s amount (greater than %s, max %s)", what, zero, max);
+    } else {
+        snprintf(out, n, "Enter %s amount (greater than %s)", what, zero);
+    }
+}
+
+/* prompt for a positive amount in cents (greater than 0) and optional upper limit */
+static long long promptAmount(const char *promptText, const char *cur, long long maxAllowed, bool enforceMax) {
+    char buf[64], err[160];
+    long long val;
     while (1) {
-        printf("%s: RM ", promptText);
+        printf("%s: %s ", promptText, amountPrefix(cur));
         readLine(buf, sizeof(buf));
-        // check string: allow digits and at most one dot
-        int dots = 0;
-        int i;
-        if (buf[0] == '-' ) { printf("Error: negative amounts not allowed.\n"); continue; }
-        for (i = 0; buf[i]; ++i) {
-            if (buf[i] == '.') { if (++dots > 1) break; continue; }
-            if (!isdigit((unsigned char)buf[i])) break;
-        }
-        if (buf[0] == '\0' || buf[i] != '\0') {
-            printf("Error: please enter a valid number (e.g., 10.50). You typed: %s\n", buf);
-            continue;
-        }
-        errno = 0;
-        val = strtod(buf, NULL);
-        if (errno != 0) { printf("Error: invalid number.\n"); continue; }
-        if (!(val > 0.0)) { printf("Error: amount must be greater than RM0.00.\n"); continue; }
-        if (enforceMax && val > maxAllowed) {
-            printf("Error: amount exceeds the allowed maximum of RM%.2f per operation.\n", maxAllowed);
-            continue;
-        }
-        // valid
+        if (!checkAmount(buf, cur, maxAllowed, enforceMax, &val, err, sizeof(err))) { printf("Error: %s\n", err); continue; }
         break;
     }
     return val;
 }
 
+/* prompt for a currency code (see checkCurrency); empty input picks defaultCur */
+static void promptCurrency(char *out, size_t n, const char *defaultCur, Account *held) {
+    char err[160];
+    while (1) {
+        printf("Currency (3-letter code, Enter for %s): ", defaultCur);
+        readLine(out, n);
+        if (!checkCurrency(out, n, defaultCur, held, err, sizeof(err))) { printf("Error: %s\n", err); continue; }
+        break;
+    }
+}
+
+/* ---------- Menus ---------- */
+
+/* the console and teller sessions list and match their menus the same way */
+typedef struct {
+    const char *label;   /* e.g. "Remittance" */
+    const char *shown;   /* keywords as listed, e.g. "remit / remittance" */
+    const char *words;   /* every accepted keyword, space separated */
+} MenuItem;
+
+/* "N) Label (keywords)" per item, then the "Select option: " prompt */
+static void formatMenu(const MenuItem *items, int nItems, char *out, size_t n) {
+    size_t len = (size_t)snprintf(out, n, "\nMENU: (type number or keyword)\n");
+    for (int i = 0; i < nItems && len < n; ++i) {
+        char head[64];
+        snprintf(head, sizeof(head), "%d) %s", i + 1, items[i].label);
+        len += (size_t)snprintf(out + len, n - len, "%-17s(%s)\n", head, items[i].shown);
+    }
+    if (len < n) snprintf(out + len, n - len, "Select option: ");
+}
+
+/* 1-based number of the item picked by a number or keyword (any case), 0 if none */
+static int menuChoice(const MenuItem *items, int nItems, const char *input) {
+    char in[32];
+    snprintf(in, sizeof(in), "%s", input);
+    for (size_t i = 0; in[i]; ++i) in[i] = (char)tolower((unsigned char)in[i]);
+    for (int i = 0; i < nItems; ++i) {
+        char num[8];
+        snprintf(num, sizeof(num), "%d", i + 1);
+        if (strcmp(in, num) == 0) return i + 1;
+        size_t wl = strlen(in);
+        for (const char *w = items[i].words; wl > 0 && *w; ) {
+            size_t len = strcspn(w, " ");
+            if (len == wl && strncmp(w, in, len) == 0) return i + 1;
+            w += len + (w[len] == ' ');
+        }
+    }
+    return 0;
+}
+
 /* ---------- Core operations ---------- */
 
 /* Helper function to check if a name contains only letters and spaces, minimum length, and at least one space */
@@ -353,6 +1230,185 @@ int isValidName(const char *name) {
     return 1; 
 }
 
+/* remittance fee in basis points, based on sender/receiver account types */
+static int remitFeeBps(const char *fromType, const char *toType) {
+    if (strcmp(fromType, "savings") == 0 && strcmp(toType, "current") == 0) return 200;
+    if (strcmp(fromType, "current") == 0 && strcmp(toType, "savings") == 0) return 300;
+    return 0;
+}
+
+/* build the journal entry for a remittance: the fee is booked to FEE_INCOME in the
+   sending currency, and cross-currency legs clear through FX_POSITION */
+static bool buildRemitEntry(JournalEntry *e, Account *from, Account *to, const char *cur,
+                            long long amt, long long *fee, long long *credited, char *err, size_t errn) {
+    *fee = feeCents(amt, remitFeeBps(from->type, to->type));
+    if (!convertAmount(amt, cur, to->currency, credited)) {
+        snprintf(err, errn, "no exchange rate available for %s -> %s", cur, to->currency);
+        return false;
+    }
+    if (*credited <= 0) {
+        char zero[48];
+        formatMoney(zero, sizeof(zero), to->currency, 0);
+        snprintf(err, errn, "amount too small; it converts to %s", zero);
+        return false;
+    }
+    memset(e, 0, sizeof(*e));
+    snprintf(e->memo, sizeof(e->memo), "REMIT %s to %s", from->accNum, to->accNum);
+    journalAdd(e, LEDGER_CUSTOMER, from, cur, amt + *fee);
+    journalAdd(e, LEDGER_FEE_INCOME, NULL, cur, -*fee);
+    if (strcmp(cur, to->currency) == 0) {
+        journalAdd(e, LEDGER_CUSTOMER, to, cur, -amt);
+    } else {
+        journalAdd(e, LEDGER_FX_POSITION, NULL, cur, -amt);
+        journalAdd(e, LEDGER_FX_POSITION, NULL, to->currency, *credited);
+        journalAdd(e, LEDGER_CUSTOMER, to, to->currency, -*credited);
+    }
+    return true;
+}
+
+/* ---------- Shared operations ----------
+
+   The console commands and the teller-session jobs both go through these,
+   so each business rule lives in one place. They reload what they change,
+   post, log, and leave either the success text in result or the reason in
+   err (no "Error: " prefix, no trailing period). Server jobs call them
+   under g_storeLock. */
+
+/* deposits may open a new currency balance and are capped at
+   MAX_DEPOSIT_BASE, expressed in the deposit currency */
+static bool depositLimit(Account *a, const char *cur, long long *maxCents, char *err, size_t n) {
+    if (!openBalance(a, cur)) {
+        snprintf(err, n, "account already holds %d currencies; cannot open a %s balance", MAX_BALANCES, cur);
+        return false;
+    }
+    if (!convertAmount(MAX_DEPOSIT_BASE, BASE_CURRENCY, cur, maxCents)) {
+        snprintf(err, n, "no exchange rate loaded for %s", cur);
+        return false;
+    }
+    return true;
+}
+
+/* balance an account can be debited from */
+static Balance *heldBalance(Account *a, const char *cur, char *err, size_t n) {
+    Balance *b = findBalance(a, cur);
+    if (!b) snprintf(err, n, "account %s holds no %s balance", a->accNum, cur);
+    return b;
+}
+
+/* receiver must be well formed, registered and not the sender (reads storage) */
+static bool checkReceiver(const char *fromAcc, const char *toAcc, char *err, size_t n) {
+    char why[160];
+    if (!checkAccountNumber(toAcc, why, sizeof(why))) { snprintf(err, n, "invalid receiver account format"); return false; }
+    if (strcmp(toAcc, fromAcc) == 0) { snprintf(err, n, "sender and receiver must be different accounts"); return false; }
+    if (!accountExists(toAcc)) { snprintf(err, n, "receiver account %s not found", toAcc); return false; }
+    return true;
+}
+
+/* a is fully filled in except for the account number, which is assigned here */
+static bool doCreate(Account *a, char *result, size_t rn, char *err, size_t en) {
+    generateAccountNumber(a->accNum, sizeof(a->accNum));
+    if (!saveAccountToFile(a)) { snprintf(err, en, "failed to save account. Check file permissions"); return false; }
+    int len = snprintf(result, rn, "%s", appendIndex(a->accNum) ? ""
+                       : "Warning: failed to write index file, account file is created but may not be listed in index.\n");
+
+    char logbuf[256], money[48];
+    snprintf(logbuf, sizeof(logbuf), "CREATE account %s (Name: %s, Type: %s, Currency: %s)", a->accNum, a->name, a->type, a->currency);
+    appendLog(logbuf);
+
+    formatMoney(money, sizeof(money), a->currency, a->balances[0].cents);
+    snprintf(result + len, rn - (size_t)len, "\nSuccess: Account created!\nAccount Number: %s\nInitial Balance: %s\n", a->accNum, money);
+    return true;
+}
+
+static bool doDeposit(const char *accNum, const char *cur, long long amt, char *result, size_t rn, char *err, size_t en) {
+    Account a;
+    JournalEntry e;
+    long long maxCents;
+    char why[128], logbuf[256], amtStr[48], balStr[48];
+    if (!loadAccountFromFile(accNum, &a)) { snprintf(err, en, "failed to load account for %s", accNum); return false; }
+    if (!depositLimit(&a, cur, &maxCents, err, en)) return false;
+    if (amt > maxCents) {
+        formatMoney(balStr, sizeof(balStr), cur, maxCents);
+        snprintf(err, en, "amount exceeds the allowed maximum of %s per operation", balStr);
+        return false;
+    }
+
+    memset(&e, 0, sizeof(e));
+    snprintf(e.memo, sizeof(e.memo), "DEPOSIT to %s", accNum);
+    journalAdd(&e, LEDGER_CASH, NULL, cur, amt);
+    journalAdd(&e, LEDGER_CUSTOMER, &a, cur, -amt);
+    if (!postJournal(&e, why, sizeof(why))) { snprintf(err, en, "failed to update account (%s)", why); return false; }
+
+    formatMoney(amtStr, sizeof(amtStr), cur, amt);
+    formatMoney(balStr, sizeof(balStr), cur, findBalance(&a, cur)->cents);
+    snprintf(logbuf, sizeof(logbuf), "DEPOSIT %s to %s (NewBal: %s)", amtStr, accNum, balStr);
+    appendLog(logbuf);
+    snprintf(result, rn, "Success: Deposited %s to account %s.\nNew balance: %s\n", amtStr, accNum, balStr);
+    return true;
+}
+
+static bool doWithdraw(const char *accNum, const char *cur, long long amt, char *result, size_t rn, char *err, size_t en) {
+    Account a;
+    JournalEntry e;
+    Balance *b;
+    char why[128], logbuf[256], amtStr[48], balStr[48];
+    if (!loadAccountFromFile(accNum, &a)) { snprintf(err, en, "failed to load account for %s", accNum); return false; }
+    if (!(b = heldBalance(&a, cur, err, en))) return false;
+    if (amt > b->cents) {
+        formatMoney(balStr, sizeof(balStr), cur, b->cents);
+        snprintf(err, en, "insufficient funds. You have %s available", balStr);
+        return false;
+    }
+
+    memset(&e, 0, sizeof(e));
+    snprintf(e.memo, sizeof(e.memo), "WITHDRAW from %s", accNum);
+    journalAdd(&e, LEDGER_CUSTOMER, &a, cur, amt);
+    journalAdd(&e, LEDGER_CASH, NULL, cur, -amt);
+    if (!postJournal(&e, why, sizeof(why))) { snprintf(err, en, "failed to update account after withdrawal (%s)", why); return false; }
+
+    formatMoney(amtStr, sizeof(amtStr), cur, amt);
+    formatMoney(balStr, sizeof(balStr), cur, b->cents);
+    snprintf(logbuf, sizeof(logbuf), "WITHDRAW %s from %s (NewBal: %s)", amtStr, accNum, balStr);
+    appendLog(logbuf);
+    snprintf(result, rn, "Success: Withdrawn %s from account %s.\nNew balance: %s\n", amtStr, accNum, balStr);
+    return true;
+}
+
+/* fee rules apply in the sending currency; the receiver is credited in their primary currency */
+static bool doRemit(const char *fromAcc, const char *toAcc, const char *cur, long long amt,
+                    char *result, size_t rn, char *err, size_t en) {
+    Account from, to;
+    JournalEntry e;
+    Balance *src;
+    long long fee, credited;
+    char why[128], logbuf[320], amtStr[48], feeStr[48], balStr[48], credStr[48];
+    if (!loadAccountFromFile(fromAcc, &from)) { snprintf(err, en, "failed to load sender account"); return false; }
+    if (!loadAccountFromFile(toAcc, &to)) { snprintf(err, en, "failed to load receiver account"); return false; }
+    if (!(src = heldBalance(&from, cur, err, en))) return false;
+    if (!buildRemitEntry(&e, &from, &to, cur, amt, &fee, &credited, err, en)) return false;
+    formatMoney(amtStr, sizeof(amtStr), cur, amt);
+    formatMoney(feeStr, sizeof(feeStr), cur, fee);
+    formatMoney(credStr, sizeof(credStr), to.currency, credited);
+    // available balance must cover amount + fee
+    if (amt + fee > src->cents) {
+        formatMoney(balStr, sizeof(balStr), cur, src->cents);
+        snprintf(err, en, "insufficient funds. Transfer (%s) + fee (%s) exceeds your balance %s", amtStr, feeStr, balStr);
+        return false;
+    }
+    if (!postJournal(&e, why, sizeof(why))) { snprintf(err, en, "failed to post remittance (%s)", why); return false; }
+
+    formatMoney(balStr, sizeof(balStr), cur, src->cents);
+    snprintf(logbuf, sizeof(logbuf), "REMIT %s from %s to %s (Fee: %s) SenderNewBal: %s Credited: %s", amtStr, fromAcc, toAcc, feeStr, balStr, credStr);
+    appendLog(logbuf);
+    int len = snprintf(result, rn, "Success: Sent %s from %s to %s.\n", amtStr, fromAcc, toAcc);
+    if (strcmp(cur, to.currency) != 0) len += snprintf(result + len, rn - (size_t)len, "Receiver credited: %s\n", credStr);
+    if (fee > 0) len += snprintf(result + len, rn - (size_t)len, "Fee applied: %s\n", feeStr);
+    snprintf(result + len, rn - (size_t)len, "Sender new balance: %s\n", balStr);
+    return true;
+}
+
+/* ---------- Console commands ---------- */
+
 static void cmdCreate() {
     Account a;
     memset(&a, 0, sizeof(a));
@@ -382,31 +1438,24 @@ static void cmdCreate() {
     printf("Name '%s' successfully validated. Continuing account setup...\n", a.name);
 
     promptID(a.id, sizeof(a.id));
+    char err[160];
     while (1) {
         printf("Account Type (savings/current): ");
         readLine(a.type, sizeof(a.type));
-        for (size_t i=0;i<strlen(a.type);++i) a.type[i]=tolower((unsigned char)a.type[i]);
-        if (strcmp(a.type,"savings")==0 || strcmp(a.type,"current")==0) break;
-        printf("Error: invalid account type. Enter 'savings' or 'current'.\n");
+        if (checkAccountType(a.type, err, sizeof(err))) break;
+        printf("Error: %s\n", err);
     }
     promptPIN(a.pin, sizeof(a.pin), "Enter 4-digit PIN");
-    a.balance = 0.00;
-    generateAccountNumber(a.accNum, sizeof(a.accNum));
-
-    if (!saveAccountToFile(&a)) {
-        printf("Error: failed to save account. Check file permissions.\n");
-        return;
-    }
-    if (!appendIndex(a.accNum)) {
-        printf("Warning: failed to write index file, account file is created but may not be listed in index.\n");
-    }
-
-    char logbuf[256];
-    snprintf(logbuf, sizeof(logbuf), "CREATE account %s (Name: %s, Type: %s)", a.accNum, a.name, a.type);
-    appendLog(logbuf);
-
-    printf("\nSuccess: Account created!\n");
-    printf("Account Number: %s\nInitial Balance: RM%.2f\n", a.accNum, a.balance);
+    char cur[8];
+    promptCurrency(cur, sizeof(cur), BASE_CURRENCY, NULL);
+    strcpy(a.currency, cur);
+    a.nBalances = 1;
+    strcpy(a.balances[0].currency, cur);
+    a.balances[0].cents = 0;
+
+    char result[320];
+    if (!doCreate(&a, result, sizeof(result), err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+    printf("%s", result);
     printProgressBar("Finalizing creation...");
 }
 
@@ -469,6 +1518,19 @@ static void cmdDelete() {
         printf("Delete cancelled by user.\n"); return;
     }
 
+    // pay out whatever is left so the books stay balanced
+    JournalEntry e;
+    char err[128];
+    memset(&e, 0, sizeof(e));
+    snprintf(e.memo, sizeof(e.memo), "CLOSE account %s", accNum);
+    for (int k = 0; k < a.nBalances; ++k) {
+        journalAdd(&e, LEDGER_CUSTOMER, &a, a.balances[k].currency, a.balances[k].cents);
+        journalAdd(&e, LEDGER_CASH, NULL, a.balances[k].currency, -a.balances[k].cents);
+    }
+    if (e.nLines > 0 && !postJournal(&e, err, sizeof(err))) {
+        printf("Error: failed to close out balances (%s). Delete aborted.\n", err); return;
+    }
+
     // remove file and index entry
     char path[256];
     snprintf(path, sizeof(path), "%s/%s.txt", DB_DIR, accNum);
@@ -502,20 +1564,18 @@ static void cmdDeposit() {
         return; 
     }
 
-    printf("Current balance: RM%.2f\n", a.balance);
-   
-    double amt = promptAmount("Enter deposit amount (greater than RM0.00, max RM50,000.00)", 50000.0, true);
+    printf("Current balances:\n");
+    printBalances(&a);
 
-    a.balance += amt;
-    if (!updateAccountFile(&a)) {
-        printf("Error: failed to update account file.\n"); return;
-    }
+    char cur[8], err[256], result[320], prompt[160];
+    long long maxCents;
+    promptCurrency(cur, sizeof(cur), a.currency, NULL);
+    if (!depositLimit(&a, cur, &maxCents, err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+    amountPrompt(prompt, sizeof(prompt), "deposit", cur, maxCents, true);
+    long long amt = promptAmount(prompt, cur, maxCents, true);
 
-    char logbuf[256];
-    snprintf(logbuf, sizeof(logbuf), "DEPOSIT RM%.2f to %s (NewBal: RM%.2f)", amt, accNum, a.balance);
-    appendLog(logbuf);
-
-    printf("Success: Deposited RM%.2f to account %s.\nNew balance: RM%.2f\n", amt, accNum, a.balance);
+    if (!doDeposit(accNum, cur, amt, result, sizeof(result), err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+    printf("%s", result);
     printProgressBar("Updating account...");
 }
 
@@ -534,24 +1594,17 @@ static void cmdWithdraw() {
         return; 
     }
 
-    printf("Available balance: RM%.2f\n", a.balance);
-    double amt = promptAmount("Enter withdrawal amount (greater than RM0.00)", 0.0, false);
+    printf("Available balances:\n");
+    printBalances(&a);
 
-    if (amt > a.balance) {
-        printf("Error: insufficient funds. You have RM%.2f available.\n", a.balance);
-        return;
-    }
+    char cur[8], err[256], result[320], prompt[128];
+    promptCurrency(cur, sizeof(cur), a.currency, &a);
+    if (!heldBalance(&a, cur, err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+    amountPrompt(prompt, sizeof(prompt), "withdrawal", cur, 0, false);
+    long long amt = promptAmount(prompt, cur, 0, false);
 
-    a.balance -= amt;
-    if (!updateAccountFile(&a)) {
-        printf("Error: failed to update account file after withdrawal.\n"); return;
-    }
-
-    char logbuf[256];
-    snprintf(logbuf, sizeof(logbuf), "WITHDRAW RM%.2f from %s (NewBal: RM%.2f)", amt, accNum, a.balance);
-    appendLog(logbuf);
-
-    printf("Success: Withdrawn RM%.2f from account %s.\nNew balance: RM%.2f\n", amt, accNum, a.balance);
+    if (!doWithdraw(accNum, cur, amt, result, sizeof(result), err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+    printf("%s", result);
     printProgressBar("Processing withdrawal...");
 }
 
@@ -577,42 +1630,111 @@ static void cmdRemit() {
     }
     if (!strCaseEqual(senderName, from.name)) { printf("Error: provided name does not match account name on file.\n"); return; }
 
-    char toAcc[16];
+    char toAcc[16], err[256], result[320], prompt[128];
     printf("Receiver account number: ");
     readLine(toAcc, sizeof(toAcc));
-    if (!isDigits(toAcc) || strlen(toAcc) < 7 || strlen(toAcc) > 9) { printf("Error: invalid receiver account format.\n"); return; }
-    if (!accountExists(toAcc)) { printf("Error: receiver account %s not found.\n", toAcc); return; }
-    if (strcmp(toAcc, fromAcc) == 0) { printf("Error: sender and receiver must be different accounts.\n"); return; }
-
-    Account to;
-    if (!loadAccountFromFile(toAcc, &to)) { printf("Error: failed to load receiver account.\n"); return; }
-
-    double amt = promptAmount("Enter transfer amount (greater than RM0.00)", 0.0, false);
-    // apply fee rules:
-    double fee = 0.0;
-    if (strcmp(from.type, "savings") == 0 && strcmp(to.type, "current") == 0) fee = amt * 0.02;
-    else if (strcmp(from.type, "current") == 0 && strcmp(to.type, "savings") == 0) fee = amt * 0.03;
-    // ensure available balance covers amt + fee
-    if (amt + fee > from.balance) {
-        printf("Error: insufficient funds. Transfer (%0.2f) + fee (%0.2f) exceeds your balance RM%.2f.\n", amt, fee, from.balance);
-        return;
+    if (!checkReceiver(fromAcc, toAcc, err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+
+    printf("Sender balances:\n");
+    printBalances(&from);
+    char cur[8];
+    promptCurrency(cur, sizeof(cur), from.currency, &from);
+    if (!heldBalance(&from, cur, err, sizeof(err))) { printf("Error: %s.\n", err); return; }
+    amountPrompt(prompt, sizeof(prompt), "transfer", cur, 0, false);
+    long long amt = promptAmount(prompt, cur, 0, false);
+
+    if (!doRemit(fromAcc, toAcc, cur, amt, result, sizeof(result), err, sizeof(err))) {
+        printf("Error: %s. Remittance aborted.\n", err); return;
     }
+    printf("%s", result);
+    printProgressBar("Transferring funds...");
+}
 
-    from.balance -= (amt + fee);
-    to.balance += amt;
+/* post a file of remittances ("fromAcc PIN toAcc amount [currency]" per line),
+   writing the journal in batches instead of once per transfer */
+static void cmdBulk() {
+    printf("\n--- Bulk Remittance ---\n");
+    char path[256];
+    printf("Batch file path (lines: fromAcc PIN toAcc amount [currency]): ");
+    readLine(path, sizeof(path));
+    FILE *f = fopen(path, "r");
+    if (!f) { printf("Error: cannot open %s.\n", path); return; }
 
-    if (!updateAccountFile(&from) || !updateAccountFile(&to)) {
-        printf("Error: failed to update account file(s) after remittance. Aborting.\n"); return;
+    char line[256], err[128];
+    int lineNo = 0, posted = 0, failed = 0;
+    g_journal.autoFlush = false;
+    while (fgets(line, sizeof(line), f)) {
+        ++lineNo;
+        line[strcspn(line, "\n")] = 0;
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        char fromAcc[16], pin[8], toAcc[16], amtStr[32], cur[8] = "";
+        int n = sscanf(line, "%15s %7s %15s %31s %7s", fromAcc, pin, toAcc, amtStr, cur);
+        Account from, to;
+        long long amt, fee, credited;
+        JournalEntry e;
+        const char *why = NULL;
+        if (n < 4) why = "malformed line";
+        else if (strcmp(fromAcc, toAcc) == 0) why = "sender and receiver are the same account";
+        else if (!loadAccountFromFile(fromAcc, &from)) why = "sender account not found";
+        else if (strcmp(pin, from.pin) != 0) why = "PIN incorrect";
+        else if (!loadAccountFromFile(toAcc, &to)) why = "receiver account not found";
+        else if (!parseFixed(amtStr, 2, &amt) || amt <= 0) why = "invalid amount";
+        if (!why) {
+            if (cur[0] == '\0') strcpy(cur, from.currency);
+            for (size_t i = 0; i < strlen(cur); ++i) cur[i] = toupper((unsigned char)cur[i]);
+            if (!findBalance(&from, cur)) why = "sender holds no balance in that currency";
+            else if (!buildRemitEntry(&e, &from, &to, cur, amt, &fee, &credited, err, sizeof(err))) why = err;
+            else if (!postJournal(&e, err, sizeof(err))) why = err;
+        }
+        if (why) { printf("Line %d: skipped (%s).\n", lineNo, why); ++failed; }
+        else ++posted;
     }
+    fclose(f);
+    g_journal.autoFlush = true;
+    if (!flushJournal()) printf("Warning: failed to write journal to %s.\n", JOURNAL_FILE);
 
-    char logbuf[256];
-    snprintf(logbuf, sizeof(logbuf), "REMIT RM%.2f from %s to %s (Fee: RM%.2f) SenderNewBal: RM%.2f", amt, fromAcc, toAcc, fee, from.balance);
+    char logbuf[320];
+    snprintf(logbuf, sizeof(logbuf), "BULK REMIT from %s (%d posted, %d skipped)", path, posted, failed);
     appendLog(logbuf);
+    printf("Bulk job finished: %d posted, %d skipped.\n", posted, failed);
+    printf("Books %s.\n", booksBalance() ? "balance" : "DO NOT balance");
+}
 
-    printf("Success: Sent RM%.2f from %s to %s.\n", amt, fromAcc, toAcc);
-    if (fee > 0.0) printf("Fee applied: RM%.2f\n", fee);
-    printf("Sender new balance: RM%.2f\n", from.balance);
-    printProgressBar("Transferring funds...");
+/* trial balance from the running totals, then a full check against the account files */
+static void cmdBooks() {
+    printf("\n--- Trial Balance ---\n");
+    char d[32], c[32], cash[32], fx[32], cust[32], fees[32];
+    for (int i = 0; i < g_journal.nTotals; ++i) {
+        const LedgerTotals *t = &g_journal.totals[i];
+        formatAmount(d, sizeof(d), t->debits);
+        formatAmount(c, sizeof(c), t->credits);
+        formatAmount(cash, sizeof(cash), t->cash);
+        formatAmount(fx, sizeof(fx), t->fxPosition);
+        formatAmount(cust, sizeof(cust), t->customers);
+        formatAmount(fees, sizeof(fees), t->feeIncome);
+        printf("%s: debits %s, credits %s\n", t->currency, d, c);
+        printf("     CASH %s + FX_POSITION %s | CUSTOMERS %s + FEE_INCOME %s\n", cash, fx, cust, fees);
+    }
+    printf("Journal entries posted: %lld\n", g_journal.seq);
+    printf("Reconciling against account files and %s...\n", JOURNAL_FILE);
+    bool reconciled = reconcileLedger();
+    printf("Books %s.\n", booksBalance() && reconciled ? "balance" : "DO NOT balance");
+}
+
+/* show the loaded exchange rates, reloading them first if the file changed */
+static void cmdRates() {
+    printf("\n--- Exchange Rates ---\n");
+    if (!refreshRatesIfChanged()) printf("Warning: could not read %s; keeping previously loaded rates.\n", RATES_FILE);
+    const RateTable *t = acquireRates();
+    char rate[32];
+    if (!t) printf("No rates loaded.\n");
+    for (int i = 0; t && i < t->count; ++i) {
+        snprintf(rate, sizeof(rate), "%lld.%04lld", t->rates[i].rate / RATE_SCALE, t->rates[i].rate % RATE_SCALE);
+        printf(" 1 %s = RM%s\n", t->rates[i].currency, rate);
+    }
+    releaseRates();
+    printf("Replace %s (write a new file, then rename it over the old one) to change rates; changes are picked up without restarting.\n", RATES_FILE);
 }
 
 static void cmdHelp() {
@@ -628,9 +1750,9 @@ static void cmdHelp() {
     if (strcmp(choice, "1") == 0) {
         printf("\nCreate account: choose 'Create Account' from menu, then provide Name, 7-digit ID, account type (savings/current), 4-digit PIN. Account number will be generated.\n");
     } else if (strcmp(choice, "2") == 0) {
-        printf("\nDeposit/Withdraw: choose deposit or withdraw, authenticate with account number and PIN. Deposit allowed > RM0 and ≤ RM50,000 per operation.\n");
+        printf("\nDeposit/Withdraw: choose deposit or withdraw, authenticate with account number and PIN. Deposit allowed > RM0 and ≤ RM50,000 (or the equivalent in the chosen currency) per operation.\n");
     } else if (strcmp(choice, "3") == 0) {
-        printf("\nRemittance: sender authenticates with PIN. Savings->Current: 2%% fee. Current->Savings: 3%% fee. Fee deducted from sender.\n");
+        printf("\nRemittance: sender authenticates with PIN. Savings->Current: 2%% fee. Current->Savings: 3%% fee. Fee deducted from sender in the sending currency and booked as bank fee income. The receiver is credited in their account currency using the loaded exchange rates.\n");
     } else if (strcmp(choice, "4") == 0) {
         printf("\nSend a help request. Enter your email or phone to be notified (saved locally for now).\n");
         char contact[128], issue[256];
@@ -652,7 +1774,612 @@ static void cmdHelp() {
     }
 }
 
+/* ---------- Teller session server ---------- */
+
+/* `--serve <socket>` runs many teller sessions over a local socket in one
+   process. A single poll() loop owns every connection; each session is a
+   coroutine that yields whenever it needs a line of input or has handed
+   file work to the worker pool, so a slow teller never blocks the others.
+   Output is collected per session and written once per prompt.
+   Sessions offer customer operations only. The server holds the database
+   lock, so admin work (delete, rates, books, bulk) means stopping it and
+   using the console. */
+
+#define DEFAULT_WORKERS 4
+#define MAX_WORKERS 64
+#define SESSION_IN_SIZE 1024
+#define SESSION_OUT_SIZE 8192
+#define HOUSEKEEPING_SECS 1    /* rate refresh and journal flush interval */
+
+/* stackless coroutines: pc holds the __LINE__ to resume at, so only one
+   yield per source line and no locals are kept across a yield */
+#define CO_BEGIN(pc)        switch (pc) { case 0:
+#define CO_YIELD(pc)        do { (pc) = __LINE__; return false; case __LINE__:; } while (0)
+#define CO_EXIT(pc)         do { (pc) = 0; return true; } while (0)
+#define CO_END(pc)          } (pc) = 0; return true
+/* run a sub-coroutine to completion, yielding whenever it yields */
+#define CO_CALL(pc, s, fn)  do { (pc) = __LINE__; /* fall through */ case __LINE__: if (!fn(s)) return false; } while (0)
+/* hand fn to the worker pool and resume once it has run */
+#define CO_AWAIT(pc, s, fn) do { submitJob((s), (fn)); CO_YIELD(pc); } while (0)
+/* show text and read lines until cond accepts one (cond reads s->line, fills s->err) */
+#define CO_PROMPT(pc, s, text, cond) do { \
+        sessionPuts((s), (text)); \
+        CO_YIELD(pc); \
+        if (cond) break; \
+        sessionPrintf((s), "Error: %s\n", (s)->err); \
+    } while (1)
+
+typedef struct Session Session;
+typedef void (*SessionJob)(Session *s);
+
+struct Session {
+    int fd;
+    bool busy;                 /* a storage job is queued or running */
+    bool closing;              /* peer hung up or the session ended */
+    SessionJob job;
+    Session *next;             /* link in the pool's job or done list */
+    int co, opCo, loginCo;     /* resume points: menu, operation, login */
+    int choice;                /* menu item being run */
+    size_t inLen, outLen, outOff;
+    char in[SESSION_IN_SIZE];
+    char out[SESSION_OUT_SIZE];
+    char line[256];            /* current input line */
+    char err[256];
+    char prompt[192];
+    char result[320];          /* success text produced by a job */
+    bool ok;                   /* outcome of the last job */
+    char accNum[16], toAcc[16], pin[8], cur[8], senderName[100];
+    long long amount, maxAmount;
+    Account acc;
+};
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    Session *head, *tail;      /* queued jobs */
+    Session *done;             /* finished jobs waiting for the event loop */
+    bool stop;
+    int wakeFd[2];             /* self-pipe: workers -> event loop */
+} g_pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, NULL, false, { -1, -1 } };
+
+/* serialises read-modify-write of account files and the journal */
+static pthread_mutex_t g_storeLock = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile sig_atomic_t g_stopServer = 0;
+
+static void onStopSignal(int sig) {
+    (void)sig;
+    g_stopServer = 1;
+}
+
+static void sessionPuts(Session *s, const char *text) {
+    size_t len = strlen(text), room = sizeof(s->out) - s->outLen;
+    if (len > room) len = room; // peer is not reading; drop the overflow
+    memcpy(s->out + s->outLen, text, len);
+    s->outLen += len;
+}
+
+static void sessionPrintf(Session *s, const char *fmt, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    sessionPuts(s, buf);
+}
+
+static void sessionBalances(Session *s, const Account *a) {
+    char money[48];
+    for (int i = 0; i < a->nBalances; ++i) {
+        formatMoney(money, sizeof(money), a->balances[i].currency, a->balances[i].cents);
+        sessionPrintf(s, "  %s%s\n", money, i == 0 ? " (primary)" : "");
+    }
+}
+
+/* same wording as the console prompts, e.g. "Enter deposit amount (greater than RM0.00, max RM50000.00): RM " */
+static void sessionAmountPrompt(Session *s, const char *what, bool showMax) {
+    char text[160];
+    amountPrompt(text, sizeof(text), what, s->cur, s->maxAmount, showMax);
+    snprintf(s->prompt, sizeof(s->prompt), "%s: %s ", text, amountPrefix(s->cur));
+}
+
+/* ---------- Worker pool ---------- */
+
+static void submitJob(Session *s, SessionJob fn) {
+    s->job = fn;
+    s->busy = true;
+    s->next = NULL;
+    pthread_mutex_lock(&g_pool.lock);
+    if (g_pool.tail) g_pool.tail->next = s; else g_pool.head = s;
+    g_pool.tail = s;
+    pthread_cond_signal(&g_pool.ready);
+    pthread_mutex_unlock(&g_pool.lock);
+}
+
+static void *workerMain(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_pool.lock);
+    for (;;) {
+        while (!g_pool.head && !g_pool.stop) pthread_cond_wait(&g_pool.ready, &g_pool.lock);
+        if (!g_pool.head) break; // stopping and nothing left to run
+        Session *s = g_pool.head;
+        g_pool.head = s->next;
+        if (!g_pool.head) g_pool.tail = NULL;
+        pthread_mutex_unlock(&g_pool.lock);
+
+        s->job(s);
+
+        pthread_mutex_lock(&g_pool.lock);
+        s->next = g_pool.done;
+        g_pool.done = s;
+        pthread_mutex_unlock(&g_pool.lock);
+        ssize_t w = write(g_pool.wakeFd[1], "x", 1); // a full pipe already means "wake up"
+        (void)w;
+        pthread_mutex_lock(&g_pool.lock);
+    }
+    pthread_mutex_unlock(&g_pool.lock);
+    return NULL;
+}
+
+/* ---------- Storage jobs (run on workers) ---------- */
+
+/* jobs read the session's answers and leave s->ok plus s->result or s->err */
+
+static void jobFindAccount(Session *s) {
+    s->ok = accountExists(s->accNum);
+}
+
+static void jobLogin(Session *s) {
+    s->ok = loadAccountFromFile(s->accNum, &s->acc) && strcmp(s->pin, s->acc.pin) == 0;
+}
+
+static void jobCheckReceiver(Session *s) {
+    s->ok = checkReceiver(s->accNum, s->toAcc, s->err, sizeof(s->err));
+}
+
+/* postings run under the store lock so concurrent sessions never write
+   back a stale copy of an account */
+static void jobCreate(Session *s) {
+    pthread_mutex_lock(&g_storeLock);
+    s->ok = doCreate(&s->acc, s->result, sizeof(s->result), s->err, sizeof(s->err));
+    pthread_mutex_unlock(&g_storeLock);
+}
+
+static void jobDeposit(Session *s) {
+    pthread_mutex_lock(&g_storeLock);
+    s->ok = doDeposit(s->accNum, s->cur, s->amount, s->result, sizeof(s->result), s->err, sizeof(s->err));
+    pthread_mutex_unlock(&g_storeLock);
+}
+
+static void jobWithdraw(Session *s) {
+    pthread_mutex_lock(&g_storeLock);
+    s->ok = doWithdraw(s->accNum, s->cur, s->amount, s->result, sizeof(s->result), s->err, sizeof(s->err));
+    pthread_mutex_unlock(&g_storeLock);
+}
+
+static void jobRemit(Session *s) {
+    pthread_mutex_lock(&g_storeLock);
+    s->ok = doRemit(s->accNum, s->toAcc, s->cur, s->amount, s->result, sizeof(s->result), s->err, sizeof(s->err));
+    pthread_mutex_unlock(&g_storeLock);
+}
+
+/* ---------- Session flows ---------- */
+
+/* account number (re-asked until registered), then PIN using s->prompt;
+   s->ok says whether the PIN matched, s->acc holds the loaded account */
+static bool coLogin(Session *s) {
+    CO_BEGIN(s->loginCo);
+    for (;;) {
+        CO_PROMPT(s->loginCo, s, "Enter account number (7-9 digits): ", checkAccountNumber(s->line, s->err, sizeof(s->err)));
+        strcpy(s->accNum, s->line);
+        CO_AWAIT(s->loginCo, s, jobFindAccount);
+        if (s->ok) break;
+        sessionPrintf(s, "Error: Account number %s is not registered.\n", s->accNum);
+    }
+    sessionPrintf(s, "OK: Account %s found.\n", s->accNum);
+    CO_PROMPT(s->loginCo, s, s->prompt, checkPIN(s->line, s->err, sizeof(s->err)));
+    strcpy(s->pin, s->line);
+    sessionPuts(s, "OK: PIN accepted.\n");
+    CO_AWAIT(s->loginCo, s, jobLogin);
+    CO_END(s->loginCo);
+}
+
+static bool coCreate(Session *s) {
+    CO_BEGIN(s->opCo);
+    sessionPuts(s, "\n--- Create New Bank Account ---\n");
+    memset(&s->acc, 0, sizeof(s->acc));
+    for (;;) {
+        sessionPuts(s, "Enter full name (must contain at least a first and last name): ");
+        CO_YIELD(s->opCo);
+        if (s->line[0] == '\0') { sessionPuts(s, "Error: Name cannot be empty. Creation cancelled.\n"); CO_EXIT(s->opCo); }
+        if (strlen(s->line) < sizeof(s->acc.name) && isValidName(s->line)) break;
+        sessionPuts(s, "Warning: Invalid name format. Name must be letters and spaces only, minimum 3 characters, and contain at least two words (e.g., 'John Smith'). Please re-enter.\n");
+    }
+    strcpy(s->acc.name, s->line);
+    sessionPrintf(s, "Name '%s' successfully validated. Continuing account setup...\n", s->acc.name);
+    CO_PROMPT(s->opCo, s, "Enter Identification Number (exactly 7 digits): ", checkID(s->line, s->err, sizeof(s->err)));
+    strcpy(s->acc.id, s->line);
+    sessionPuts(s, "OK: ID accepted.\n");
+    CO_PROMPT(s->opCo, s, "Account Type (savings/current): ", checkAccountType(s->line, s->err, sizeof(s->err)));
+    strcpy(s->acc.type, s->line);
+    CO_PROMPT(s->opCo, s, "Enter 4-digit PIN (exactly 4 digits): ", checkPIN(s->line, s->err, sizeof(s->err)));
+    strcpy(s->acc.pin, s->line);
+    sessionPuts(s, "OK: PIN accepted.\n");
+    snprintf(s->prompt, sizeof(s->prompt), "Currency (3-letter code, Enter for %s): ", BASE_CURRENCY);
+    CO_PROMPT(s->opCo, s, s->prompt, checkCurrency(s->line, sizeof(s->line), BASE_CURRENCY, NULL, s->err, sizeof(s->err)));
+    strcpy(s->acc.currency, s->line);
+    s->acc.nBalances = 1;
+    strcpy(s->acc.balances[0].currency, s->acc.currency);
+    CO_AWAIT(s->opCo, s, jobCreate);
+    if (s->ok) sessionPuts(s, s->result);
+    else sessionPrintf(s, "Error: %s.\n", s->err);
+    CO_END(s->opCo);
+}
+
+static bool coDeposit(Session *s) {
+    CO_BEGIN(s->opCo);
+    sessionPuts(s, "\n--- Deposit ---\n");
+    snprintf(s->prompt, sizeof(s->prompt), "Enter 4-digit PIN (exactly 4 digits): ");
+    CO_CALL(s->opCo, s, coLogin);
+    if (!s->ok) { sessionPuts(s, "Error: authentication failed (PIN incorrect). Deposit aborted.\n"); CO_EXIT(s->opCo); }
+    sessionPuts(s, "Current balances:\n");
+    sessionBalances(s, &s->acc);
+    snprintf(s->prompt, sizeof(s->prompt), "Currency (3-letter code, Enter for %s): ", s->acc.currency);
+    CO_PROMPT(s->opCo, s, s->prompt, checkCurrency(s->line, sizeof(s->line), s->acc.currency, NULL, s->err, sizeof(s->err)));
+    strcpy(s->cur, s->line);
+    if (!depositLimit(&s->acc, s->cur, &s->maxAmount, s->err, sizeof(s->err))) { sessionPrintf(s, "Error: %s.\n", s->err); CO_EXIT(s->opCo); }
+    sessionAmountPrompt(s, "deposit", true);
+    CO_PROMPT(s->opCo, s, s->prompt, checkAmount(s->line, s->cur, s->maxAmount, true, &s->amount, s->err, sizeof(s->err)));
+    CO_AWAIT(s->opCo, s, jobDeposit);
+    if (s->ok) sessionPuts(s, s->result);
+    else sessionPrintf(s, "Error: %s.\n", s->err);
+    CO_END(s->opCo);
+}
+
+static bool coWithdraw(Session *s) {
+    CO_BEGIN(s->opCo);
+    sessionPuts(s, "\n--- Withdraw ---\n");
+    snprintf(s->prompt, sizeof(s->prompt), "Enter 4-digit PIN (exactly 4 digits): ");
+    CO_CALL(s->opCo, s, coLogin);
+    if (!s->ok) { sessionPuts(s, "Error: authentication failed (PIN incorrect). Withdrawal aborted.\n"); CO_EXIT(s->opCo); }
+    sessionPuts(s, "Available balances:\n");
+    sessionBalances(s, &s->acc);
+    snprintf(s->prompt, sizeof(s->prompt), "Currency (3-letter code, Enter for %s): ", s->acc.currency);
+    CO_PROMPT(s->opCo, s, s->prompt, checkCurrency(s->line, sizeof(s->line), s->acc.currency, &s->acc, s->err, sizeof(s->err)));
+    strcpy(s->cur, s->line);
+    if (!heldBalance(&s->acc, s->cur, s->err, sizeof(s->err))) { sessionPrintf(s, "Error: %s.\n", s->err); CO_EXIT(s->opCo); }
+    sessionAmountPrompt(s, "withdrawal", false);
+    CO_PROMPT(s->opCo, s, s->prompt, checkAmount(s->line, s->cur, 0, false, &s->amount, s->err, sizeof(s->err)));
+    CO_AWAIT(s->opCo, s, jobWithdraw);
+    if (s->ok) sessionPuts(s, s->result);
+    else sessionPrintf(s, "Error: %s.\n", s->err);
+    CO_END(s->opCo);
+}
+
+static bool coRemit(Session *s) {
+    CO_BEGIN(s->opCo);
+    sessionPuts(s, "\n--- Remittance / Transfer ---\nSender full name (for verification): ");
+    CO_YIELD(s->opCo);
+    if (s->line[0] == '\0') { sessionPuts(s, "Error: name cannot be empty.\n"); CO_EXIT(s->opCo); }
+    snprintf(s->senderName, sizeof(s->senderName), "%.99s", s->line);
+    snprintf(s->prompt, sizeof(s->prompt), "Enter sender 4-digit PIN (exactly 4 digits): ");
+    CO_CALL(s->opCo, s, coLogin);
+    if (!s->ok) { sessionPuts(s, "Error: authentication failed (PIN incorrect). Remittance aborted.\n"); CO_EXIT(s->opCo); }
+    if (!strCaseEqual(s->senderName, s->acc.name)) { sessionPuts(s, "Error: provided name does not match account name on file.\n"); CO_EXIT(s->opCo); }
+
+    sessionPuts(s, "Receiver account number: ");
+    CO_YIELD(s->opCo);
+    snprintf(s->toAcc, sizeof(s->toAcc), "%.15s", s->line);
+    CO_AWAIT(s->opCo, s, jobCheckReceiver);
+    if (!s->ok) { sessionPrintf(s, "Error: %s.\n", s->err); CO_EXIT(s->opCo); }
+
+    sessionPuts(s, "Sender balances:\n");
+    sessionBalances(s, &s->acc);
+    snprintf(s->prompt, sizeof(s->prompt), "Currency (3-letter code, Enter for %s): ", s->acc.currency);
+    CO_PROMPT(s->opCo, s, s->prompt, checkCurrency(s->line, sizeof(s->line), s->acc.currency, &s->acc, s->err, sizeof(s->err)));
+    strcpy(s->cur, s->line);
+    if (!heldBalance(&s->acc, s->cur, s->err, sizeof(s->err))) { sessionPrintf(s, "Error: %s.\n", s->err); CO_EXIT(s->opCo); }
+    sessionAmountPrompt(s, "transfer", false);
+    CO_PROMPT(s->opCo, s, s->prompt, checkAmount(s->line, s->cur, 0, false, &s->amount, s->err, sizeof(s->err)));
+    CO_AWAIT(s->opCo, s, jobRemit);
+    if (s->ok) sessionPuts(s, s->result);
+    else sessionPrintf(s, "Error: %s. Remittance aborted.\n", s->err);
+    CO_END(s->opCo);
+}
+
+static bool coBalance(Session *s) {
+    CO_BEGIN(s->opCo);
+    sessionPuts(s, "\n--- Balance ---\n");
+    snprintf(s->prompt, sizeof(s->prompt), "Enter 4-digit PIN (exactly 4 digits): ");
+    CO_CALL(s->opCo, s, coLogin);
+    if (!s->ok) { sessionPuts(s, "Error: authentication failed (PIN incorrect).\n"); CO_EXIT(s->opCo); }
+    sessionPrintf(s, "Balances for account %s:\n", s->accNum);
+    sessionBalances(s, &s->acc);
+    CO_END(s->opCo);
+}
+
+/* teller sessions cover customer work only; admin commands (delete, rates,
+   books, bulk) need the console, which cannot run while the server holds
+   the database lock */
+static const MenuItem g_sessionMenu[] = {
+    { "Create", "create", "create" },
+    { "Deposit", "deposit", "deposit" },
+    { "Withdraw", "withdraw", "withdraw" },
+    { "Remittance", "remit / remittance", "remit remittance" },
+    { "Balance", "balance", "balance" },
+    { "Exit", "exit", "exit quit" },
+};
+#define SESSION_MENU_ITEMS ((int)(sizeof(g_sessionMenu) / sizeof(g_sessionMenu[0])))
+
+/* top-level teller menu; returns true when the session is over */
+static bool coSession(Session *s) {
+    CO_BEGIN(s->co);
+    sessionPuts(s, "=============================================\n"
+                   "   Welcome to Krish Enterprise Bank\n"
+                   "   Teller session\n"
+                   "=============================================\n");
+    for (;;) {
+        {
+            char menu[512];
+            formatMenu(g_sessionMenu, SESSION_MENU_ITEMS, menu, sizeof(menu));
+            sessionPuts(s, menu);
+        }
+        CO_YIELD(s->co);
+        // if/else, not switch: CO_CALL places case labels of the coroutine's own switch
+        s->choice = menuChoice(g_sessionMenu, SESSION_MENU_ITEMS, s->line);
+        if (s->choice == 1) {
+            CO_CALL(s->co, s, coCreate);
+        } else if (s->choice == 2) {
+            CO_CALL(s->co, s, coDeposit);
+        } else if (s->choice == 3) {
+            CO_CALL(s->co, s, coWithdraw);
+        } else if (s->choice == 4) {
+            CO_CALL(s->co, s, coRemit);
+        } else if (s->choice == 5) {
+            CO_CALL(s->co, s, coBalance);
+        } else if (s->choice == 6) {
+            sessionPuts(s, "Thank you for using Krish Enterprise Bank. Goodbye!\n");
+            break;
+        } else {
+            sessionPuts(s, "Invalid option. Please enter a menu number or keyword (e.g., 'create', 'deposit', 'remit', 'balance', 'exit').\n");
+        }
+    }
+    CO_END(s->co);
+}
+
+/* ---------- Event loop ---------- */
+
+/* feed complete input lines to the session until it waits on a job or its output backs up */
+static void pumpSession(Session *s) {
+    while (!s->busy && !s->closing && s->outLen < sizeof(s->out) / 2) {
+        char *nl = memchr(s->in, '\n', s->inLen);
+        size_t len;
+        if (nl) len = (size_t)(nl - s->in);
+        else if (s->inLen == sizeof(s->in)) len = s->inLen; // overlong line: take what we have
+        else break;
+        size_t take = len < sizeof(s->line) - 1 ? len : sizeof(s->line) - 1;
+        memcpy(s->line, s->in, take);
+        s->line[take] = '\0';
+        s->line[strcspn(s->line, "\r")] = '\0';
+        size_t used = nl ? len + 1 : len;
+        memmove(s->in, s->in + used, s->inLen - used);
+        s->inLen -= used;
+        if (coSession(s)) s->closing = true;
+    }
+}
+
+/* write pending output; returns false if the peer is gone */
+static bool flushSession(Session *s) {
+    while (s->outOff < s->outLen) {
+        ssize_t w = write(s->fd, s->out + s->outOff, s->outLen - s->outOff);
+        if (w > 0) { s->outOff += (size_t)w; continue; }
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (w < 0 && errno == EINTR) continue;
+        s->outLen = s->outOff = 0;
+        return false;
+    }
+    s->outLen = s->outOff = 0;
+    return true;
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/* sessions each hold a descriptor; lift the soft limit as far as allowed */
+static void raiseFdLimit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return;
+    rlim_t want = rl.rlim_max == RLIM_INFINITY ? 65536 : rl.rlim_max;
+    if (rl.rlim_cur < want) {
+        rl.rlim_cur = want;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static int runServer(const char *sockPath, int nWorkers) {
+    struct sockaddr_un addr;
+    if (strlen(sockPath) >= sizeof(addr.sun_path)) { printf("Error: socket path too long.\n"); return 1; }
+    if (nWorkers < 1 || nWorkers > MAX_WORKERS) nWorkers = DEFAULT_WORKERS;
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+    raiseFdLimit();
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) { printf("Error: cannot create socket (%s).\n", strerror(errno)); return 1; }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, sockPath);
+    // replace a stale socket from an earlier run, but never anything else
+    struct stat st;
+    if (lstat(sockPath, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            printf("Error: %s exists and is not a socket; refusing to replace it.\n", sockPath);
+            close(lfd);
+            return 1;
+        }
+        unlink(sockPath);
+    }
+    if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(lfd, SOMAXCONN) != 0 || !setNonBlocking(lfd)) {
+        printf("Error: cannot listen on %s (%s).\n", sockPath, strerror(errno));
+        close(lfd);
+        return 1;
+    }
+    if (pipe(g_pool.wakeFd) != 0 || !setNonBlocking(g_pool.wakeFd[0]) || !setNonBlocking(g_pool.wakeFd[1])) {
+        printf("Error: cannot create wake-up pipe.\n");
+        close(lfd);
+        return 1;
+    }
+    pthread_t workers[MAX_WORKERS];
+    for (int i = 0; i < nWorkers; ++i) pthread_create(&workers[i], NULL, workerMain, NULL);
+
+    // the journal is written in batches: when full, or on the housekeeping tick
+    g_journal.autoFlush = false;
+    printf("Teller server listening on %s with %d workers. Press Ctrl+C to stop.\n", sockPath, nWorkers);
+    fflush(stdout);
+
+    Session **sessions = NULL;
+    struct pollfd *pfds = NULL;
+    size_t nSessions = 0, cap = 0;
+    time_t lastTick = time(NULL);
+
+    while (!g_stopServer) {
+        if (nSessions + 2 > cap) {
+            size_t ncap = cap ? cap * 2 : 64;
+            Session **ns = realloc(sessions, ncap * sizeof(*ns));
+            if (ns) sessions = ns;
+            struct pollfd *np = realloc(pfds, (ncap + 2) * sizeof(*np));
+            if (np) pfds = np;
+            if (!ns || !np) break;
+            cap = ncap;
+        }
+        pfds[0].fd = lfd;                pfds[0].events = POLLIN;
+        pfds[1].fd = g_pool.wakeFd[0];   pfds[1].events = POLLIN;
+        for (size_t i = 0; i < nSessions; ++i) {
+            Session *s = sessions[i];
+            // a hung-up session waiting on its job would report POLLHUP on every poll()
+            pfds[i + 2].fd = s->closing && s->busy ? -1 : s->fd;
+            pfds[i + 2].events = (short)((!s->busy && !s->closing && s->inLen < sizeof(s->in) ? POLLIN : 0)
+                                         | (s->outOff < s->outLen ? POLLOUT : 0));
+        }
+        int n = poll(pfds, (nfds_t)(nSessions + 2), HOUSEKEEPING_SECS * 1000);
+        if (n < 0 && errno != EINTR) break;
+
+        // 1. resume sessions whose storage job finished
+        if (n > 0 && (pfds[1].revents & POLLIN)) {
+            char drain[256];
+            while (read(g_pool.wakeFd[0], drain, sizeof(drain)) > 0) {}
+            pthread_mutex_lock(&g_pool.lock);
+            Session *done = g_pool.done;
+            g_pool.done = NULL;
+            pthread_mutex_unlock(&g_pool.lock);
+            while (done) {
+                Session *s = done;
+                done = s->next;
+                s->busy = false;
+                if (!s->closing && coSession(s)) s->closing = true;
+                pumpSession(s);
+            }
+        }
+
+        // 2. socket input and output
+        for (size_t i = 0; n > 0 && i < nSessions; ++i) {
+            Session *s = sessions[i];
+            short re = pfds[i + 2].revents;
+            if (re & POLLIN) {
+                for (;;) {
+                    ssize_t r = read(s->fd, s->in + s->inLen, sizeof(s->in) - s->inLen);
+                    if (r > 0) { s->inLen += (size_t)r; if (s->inLen == sizeof(s->in)) break; continue; }
+                    if (r == 0) s->closing = true;
+                    else if (errno == EINTR) continue;
+                    else if (errno != EAGAIN && errno != EWOULDBLOCK) s->closing = true;
+                    break;
+                }
+                pumpSession(s);
+            } else if (re & (POLLHUP | POLLERR | POLLNVAL)) {
+                s->closing = true;
+            }
+        }
+
+        // 3. new connections
+        if (n > 0 && (pfds[0].revents & POLLIN)) {
+            for (;;) {
+                if (nSessions >= cap) break; // picked up next round once the arrays grow
+                int cfd = accept(lfd, NULL, NULL);
+                if (cfd < 0) break;
+                Session *s = calloc(1, sizeof(*s));
+                if (!s || !setNonBlocking(cfd)) { free(s); close(cfd); continue; }
+                s->fd = cfd;
+                sessions[nSessions++] = s;
+                coSession(s); // greeting and menu, then wait for the first line
+            }
+        }
+
+        // 4. one write per session per round, then drop finished sessions
+        for (size_t i = 0; i < nSessions; ) {
+            Session *s = sessions[i];
+            if (!flushSession(s)) s->closing = true;
+            // output drained: handle lines that arrived while it was backed up
+            if (s->outLen == 0 && s->inLen > 0 && !s->busy && !s->closing) {
+                pumpSession(s);
+                if (!flushSession(s)) s->closing = true;
+            }
+            if (s->closing && !s->busy && (s->outOff == s->outLen || !flushSession(s))) {
+                close(s->fd);
+                free(s);
+                sessions[i] = sessions[--nSessions];
+                continue;
+            }
+            ++i;
+        }
+
+        // 5. housekeeping: pick up new rates, write out buffered journal entries
+        if (time(NULL) - lastTick >= HOUSEKEEPING_SECS) {
+            lastTick = time(NULL);
+            refreshRatesIfChanged();
+            if (pthread_mutex_trylock(&g_storeLock) == 0) {
+                flushJournal();
+                pthread_mutex_unlock(&g_storeLock);
+            }
+        }
+    }
+
+    printf("\nStopping teller server...\n");
+    pthread_mutex_lock(&g_pool.lock);
+    g_pool.stop = true;
+    pthread_cond_broadcast(&g_pool.ready);
+    pthread_mutex_unlock(&g_pool.lock);
+    for (int i = 0; i < nWorkers; ++i) pthread_join(workers[i], NULL);
+    for (size_t i = 0; i < nSessions; ++i) { close(sessions[i]->fd); free(sessions[i]); }
+    free(sessions);
+    free(pfds);
+    close(lfd);
+    close(g_pool.wakeFd[0]);
+    close(g_pool.wakeFd[1]);
+    unlink(sockPath);
+    flushJournal();
+    return 0;
+}
+
 /* ---------- Menu & session ---------- */
+
+static const MenuItem g_consoleMenu[] = {
+    { "Create", "create", "create" },
+    { "Delete", "delete", "delete" },
+    { "Deposit", "deposit", "deposit" },
+    { "Withdraw", "withdraw", "withdraw" },
+    { "Remittance", "remit / remittance", "remit remittance" },
+    { "Help", "help", "help" },
+    { "Exit", "exit", "exit quit" },
+    { "Rates", "rates", "rates" },
+    { "Books", "books", "books" },
+    { "Bulk remit", "bulk", "bulk" },
+};
+#define CONSOLE_MENU_ITEMS ((int)(sizeof(g_consoleMenu) / sizeof(g_consoleMenu[0])))
+
 static void printHeader() {
     printf("=============================================\n");
     printf("   Welcome to Krish Enterprise Bank\n");
@@ -667,44 +2394,58 @@ static void printHeader() {
     printf("---------------------------------------------\n");
 }
 
-int main(void) {
+int main(int argc, char **argv) {
+    // teller server: banking --serve <socket path> [workers]
+    bool serve = argc >= 3 && strcmp(argv[1], "--serve") == 0;
+    // console output is flushed once per prompt by readLine(); must be set before any output
+    if (!serve) setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
     ensureDatabase();
-    char input[64];
+    if (!lockDatabase()) {
+        printf("Error: the database is in use by another console or teller server.\n"
+               "Admin commands (delete, rates, books, bulk) need the teller server stopped first.\n");
+        return 1;
+    }
+    if (!reloadRates()) printf("Warning: failed to load exchange rates from %s.\n", RATES_FILE);
+    initJournal();
+
+    if (serve) {
+        int rc = runServer(argv[2], argc >= 4 ? atoi(argv[3]) : DEFAULT_WORKERS);
+        freeRates();
+        return rc;
+    }
+
+    char input[64], menu[1024];
+    bool running = true;
 
     printHeader();
+    formatMenu(g_consoleMenu, CONSOLE_MENU_ITEMS, menu, sizeof(menu));
 
-    for (;;) {
-        printf("\nMENU: (type number or keyword)\n");
-        printf("1) Create        (create)\n");
-        printf("2) Delete        (delete)\n");
-        printf("3) Deposit       (deposit)\n");
-        printf("4) Withdraw      (withdraw)\n");
-        printf("5) Remittance    (remit / remittance)\n");
-        printf("6) Help          (help)\n");
-        printf("7) Exit          (exit)\n");
-        printf("Select option: ");
+    while (running) {
+        printf("%s", menu);
         readLine(input, sizeof(input));
-
-        for (size_t i=0;i<strlen(input);++i) input[i]=tolower((unsigned char)input[i]);
-        if (strcmp(input, "1")==0 || strcmp(input,"create")==0) {
-            cmdCreate();
-        } else if (strcmp(input,"2")==0 || strcmp(input,"delete")==0) {
-            cmdDelete();
-        } else if (strcmp(input,"3")==0 || strcmp(input,"deposit")==0) {
-            cmdDeposit();
-        } else if (strcmp(input,"4")==0 || strcmp(input,"withdraw")==0) {
-            cmdWithdraw();
-        } else if (strcmp(input,"5")==0 || strcmp(input,"remit")==0 || strcmp(input,"remittance")==0) {
-            cmdRemit();
-        } else if (strcmp(input,"6")==0 || strcmp(input,"help")==0) {
-            cmdHelp();
-        } else if (strcmp(input,"7")==0 || strcmp(input,"exit")==0 || strcmp(input,"quit")==0) {
+        refreshRatesIfChanged();
+
+        switch (menuChoice(g_consoleMenu, CONSOLE_MENU_ITEMS, input)) {
+        case 1: cmdCreate(); break;
+        case 2: cmdDelete(); break;
+        case 3: cmdDeposit(); break;
+        case 4: cmdWithdraw(); break;
+        case 5: cmdRemit(); break;
+        case 6: cmdHelp(); break;
+        case 7:
             printf("Thank you for using Krish Enterprise Bank. Goodbye!\n");
+            running = false;
             break;
-        } else {
+        case 8: cmdRates(); break;
+        case 9: cmdBooks(); break;
+        case 10: cmdBulk(); break;
+        default:
             printf("Invalid option. Please enter a menu number or keyword (e.g., 'create', 'deposit', 'remit', 'help', 'exit').\n");
         }
     }
 
+    flushJournal();
+    freeRates();
     return 0;
 }
\ No newline at end of file